@@ -0,0 +1,322 @@
+// run ./bench.sh
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "jtckdint.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if (defined(__GNUC__) || defined(__llvm__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#  include <x86intrin.h>
+#  define UNIT "tsc"
+#else
+#  define UNIT "ns"
+#endif
+
+#ifdef __cplusplus
+#  define cast(T, x) (static_cast<T>(x))
+#else
+#  define cast(T, x) ((T)(x))
+#endif
+
+#if defined(__GNUC__) || defined(__llvm__)
+#  define noinline __attribute__((__noinline__))
+#else
+#  define noinline
+#endif
+
+// Every combination of result and operand types, like test.c, is timed
+// for each operation and overflow rate. Throughput is measured with an
+// error branch after each operation, which is how checked arithmetic is
+// normally used, so mispredictions show up as the rate goes up. Latency
+// is measured by making each operand depend on the previous result.
+
+#define N 512
+#define REPS 5
+#define TRIES (N * 16)
+
+typedef int8_t i8;
+typedef uint8_t u8;
+typedef int16_t i16;
+typedef uint16_t u16;
+typedef int32_t i32;
+typedef uint32_t u32;
+typedef int64_t i64;
+typedef uint64_t u64;
+
+#define EAT(...)
+
+#ifdef ckd_have_int128
+#  define WITH_128(F) F
+typedef ckd_intmax i128;
+typedef ckd_uintmax u128;
+#else
+#  define WITH_128(F) EAT
+#endif
+
+/* clang-format off */
+#define TYPES(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, u32) \
+  F(__VA_ARGS__, u64) \
+  WITH_128(F)(__VA_ARGS__, u128) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16) \
+  F(__VA_ARGS__, i32) \
+  F(__VA_ARGS__, i64) \
+  WITH_128(F)(__VA_ARGS__, i128)
+
+// each nesting level needs its own copy, since macros can't recurse
+#define TYPES_U(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, u32) \
+  F(__VA_ARGS__, u64) \
+  WITH_128(F)(__VA_ARGS__, u128) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16) \
+  F(__VA_ARGS__, i32) \
+  F(__VA_ARGS__, i64) \
+  WITH_128(F)(__VA_ARGS__, i128)
+
+#define TYPES_V(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, u32) \
+  F(__VA_ARGS__, u64) \
+  WITH_128(F)(__VA_ARGS__, u128) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16) \
+  F(__VA_ARGS__, i32) \
+  F(__VA_ARGS__, i64) \
+  WITH_128(F)(__VA_ARGS__, i128)
+/* clang-format on */
+
+#define EACH_V(F, op, T, U) TYPES_V(F, op, T, U)
+#define EACH_U(F, op, T) TYPES_U(EACH_V, F, op, T)
+#define EACH_T(F, op) TYPES(EACH_U, F, op)
+#define FOR_CASES(F) EACH_T(F, add) EACH_T(F, sub) EACH_T(F, mul)
+
+static struct
+{
+  char const* name;
+  unsigned permille;
+} const kDists[] = {
+    {"0%", 0},
+    {"1%", 10},
+    {"50%", 500},
+    {"100%", 1000},
+};
+
+static char const* backend;
+static unsigned char* ok_a;
+static unsigned char* ok_b;
+static unsigned char* bad_a;
+static unsigned char* bad_b;
+static void* in_a;
+static void* in_b;
+static void* out;
+static volatile ckd_uintmax zero;
+static volatile ckd_uintmax sink;
+static volatile unsigned long flagged;
+
+static unsigned long long now(void)
+{
+#if defined(__GNUC__) || defined(__llvm__)
+#  if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#  endif
+#endif
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return cast(unsigned long long, ts.tv_sec) * 1000000000ull
+       + cast(unsigned long long, ts.tv_nsec);
+}
+
+static unsigned long long rnd64(void)
+{
+  static unsigned long long s = 0x9e3779b97f4a7c15ull;
+  s ^= s >> 12;
+  s ^= s << 25;
+  s ^= s >> 27;
+  return s * 2685821657736338717ull;
+}
+
+// random magnitudes of every width, and both signs
+static ckd_uintmax rnd(void)
+{
+  ckd_uintmax x = rnd64();
+  if (sizeof(x) > 8) {
+    x = x << 32 << 32 | rnd64();
+  }
+  x >>= rnd64() % (sizeof(x) * 8);
+  return rnd64() & 1 ? 0 - x : x;
+}
+
+static noinline void on_overflow(void)
+{
+  flagged = flagged + 1;
+}
+
+// Each case only defines its typed kernels, so the file compiles quickly
+// despite there being thousands of them:
+//
+//   - pick() stores random operands at index i and returns the flag
+//   - tput() performs every operation, calling on_overflow() when flagged
+//   - lat() chains each operation on the previous result
+//
+#define CASE(op, T, U, V) \
+  static bool op##_##T##_##U##_##V##_pick(size_t i) \
+  { \
+    T z; \
+    U* a = cast(U*, in_a); \
+    V* b = cast(V*, in_b); \
+    a[i] = cast(U, rnd()); \
+    b[i] = cast(V, rnd()); \
+    return ckd_##op(&z, a[i], b[i]); \
+  } \
+  static void op##_##T##_##U##_##V##_tput(void) \
+  { \
+    size_t i; \
+    T* z = cast(T*, out); \
+    U const* a = cast(U const*, in_a); \
+    V const* b = cast(V const*, in_b); \
+    for (i = 0; i < N; ++i) { \
+      if (ckd_##op(&z[i], a[i], b[i])) { \
+        on_overflow(); \
+      } \
+    } \
+  } \
+  static ckd_uintmax op##_##T##_##U##_##V##_lat(ckd_uintmax mask) \
+  { \
+    size_t i; \
+    T z = 0; \
+    ckd_uintmax dep = 0; \
+    U const* a = cast(U const*, in_a); \
+    V const* b = cast(V const*, in_b); \
+    for (i = 0; i < N; ++i) { \
+      bool o = ckd_##op(&z, cast(U, a[i] ^ cast(U, dep)), b[i]); \
+      dep = (cast(ckd_uintmax, z) | o) & mask; \
+    } \
+    return dep; \
+  }
+FOR_CASES(CASE)
+#undef CASE
+
+static struct
+{
+  char const* op;
+  char const* t;
+  char const* u;
+  char const* v;
+  size_t su;
+  size_t sv;
+  bool (*pick)(size_t);
+  void (*tput)(void);
+  ckd_uintmax (*lat)(ckd_uintmax);
+} const kCases[] = {
+#define CASE(op, T, U, V) \
+  {#op, \
+   #T, \
+   #U, \
+   #V, \
+   sizeof(U), \
+   sizeof(V), \
+   op##_##T##_##U##_##V##_pick, \
+   op##_##T##_##U##_##V##_tput, \
+   op##_##T##_##U##_##V##_lat},
+    FOR_CASES(CASE)
+#undef CASE
+};
+
+static void copy(void* dst, size_t i, void const* src, size_t j, size_t n)
+{
+  memcpy(cast(unsigned char*, dst) + i * n,
+         cast(unsigned char const*, src) + j * n,
+         n);
+}
+
+// Operands are sorted into pools by whether they overflow, and then
+// drawn from them at each rate. Some cases never overflow, e.g. when
+// the result is wider than the operands, so their rate stays at zero.
+static void run(size_t c)
+{
+  size_t i, d, r, k;
+  size_t nok = 0;
+  size_t nbad = 0;
+  size_t su = kCases[c].su;
+  size_t sv = kCases[c].sv;
+  for (i = 0; i < TRIES && (nok < N || nbad < N); ++i) {
+    if (kCases[c].pick(0)) {
+      if (nbad < N) {
+        copy(bad_a, nbad, in_a, 0, su);
+        copy(bad_b, nbad++, in_b, 0, sv);
+      }
+    } else if (nok < N) {
+      copy(ok_a, nok, in_a, 0, su);
+      copy(ok_b, nok++, in_b, 0, sv);
+    }
+  }
+  for (d = 0; d < sizeof(kDists) / sizeof(kDists[0]); ++d) {
+    size_t overflows = 0;
+    unsigned long long tput = ~0ull;
+    unsigned long long lat = ~0ull;
+    for (i = 0; i < N; ++i) {
+      bool o = nbad && (!nok || rnd64() % 1000 < kDists[d].permille);
+      k = cast(size_t, rnd64() % (o ? nbad : nok));
+      copy(in_a, i, o ? bad_a : ok_a, k, su);
+      copy(in_b, i, o ? bad_b : ok_b, k, sv);
+      overflows += o;
+    }
+    for (r = 0; r < REPS; ++r) {
+      unsigned long long t = now();
+      kCases[c].tput();
+      t = now() - t;
+      tput = t < tput ? t : tput;
+    }
+    for (r = 0; r < REPS; ++r) {
+      unsigned long long t = now();
+      sink = kCases[c].lat(zero);
+      t = now() - t;
+      lat = t < lat ? t : lat;
+    }
+    printf("%s,%s,%s,%s,%s,%s,%.3f,%.3f,%.3f,%s\n",
+           backend,
+           kCases[c].op,
+           kCases[c].t,
+           kCases[c].u,
+           kCases[c].v,
+           kDists[d].name,
+           cast(double, overflows) / N,
+           cast(double, tput) / N,
+           cast(double, lat) / N,
+           UNIT);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  size_t i;
+  backend = argc > 1 ? argv[1] : "";
+  if (!(ok_a = cast(unsigned char*, malloc(N * sizeof(ckd_uintmax))))
+      || !(ok_b = cast(unsigned char*, malloc(N * sizeof(ckd_uintmax))))
+      || !(bad_a = cast(unsigned char*, malloc(N * sizeof(ckd_uintmax))))
+      || !(bad_b = cast(unsigned char*, malloc(N * sizeof(ckd_uintmax))))
+      || !(in_a = malloc(N * sizeof(ckd_uintmax)))
+      || !(in_b = malloc(N * sizeof(ckd_uintmax)))
+      || !(out = malloc(N * sizeof(ckd_uintmax))))
+  {
+    return 1;
+  }
+  printf("backend,op,type,a,b,dist,overflow,throughput,latency,unit\n");
+  for (i = 0; i < sizeof(kCases) / sizeof(kCases[0]); ++i) {
+    run(i);
+  }
+  return 0;
+}
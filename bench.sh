@@ -0,0 +1,35 @@
+#!/bin/sh
+# prints a csv of cost per checked operation, for each backend and type
+# usage: ./bench.sh >bench.csv
+
+set -e
+
+opt=${OPT:--O2}
+header=1
+libs=
+
+run() {
+  label=$1
+  shift
+  "$@" $opt -o bench bench.c ${libs:+-xnone $libs}
+  if [ $header ]; then
+    ./bench $label
+    header=
+  else
+    ./bench $label | sed 1d
+  fi
+}
+
+run builtins cc -DJTCKDINT_OPTION_STDCKDINT=2
+run c11 cc -std=c11 -DJTCKDINT_OPTION_STDCKDINT=2
+run c++11 c++ -std=c++11 -xc++ -DJTCKDINT_OPTION_STDCKDINT=2
+if [ -f libjtckdint.a ]; then
+  libs=libjtckdint.a
+  run c11-lib cc -std=c11 -DJTCKDINT_OPTION_LIBRARY=1
+  run c++11-lib c++ -std=c++11 -xc++ -DJTCKDINT_OPTION_LIBRARY=1
+  libs=
+fi
+if echo '#include <stdckdint.h>' | cc -std=c2x -E -xc - >/dev/null 2>&1; then
+  run stdckdint cc -std=c2x -DJTCKDINT_OPTION_STDCKDINT=1
+fi
+rm -f bench
@@ -0,0 +1,153 @@
+#!/bin/sh
+# compares the code generated for each demo.c function with every backend
+# against codegen.golden, and fails if any of them got bigger or slower
+# usage: ./codegen.sh [-u]    where -u rewrites codegen.golden
+
+set -e
+
+golden=codegen.golden
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+mca=
+if command -v llvm-mca >/dev/null 2>&1 \
+    && [ "$(uname -m)" = x86_64 ]; then
+  mca=llvm-mca
+fi
+
+# same as measure, but only if the compiler is able to build the mode,
+# e.g. 32-bit libraries often aren't installed
+maybe() {
+  label=$1
+  shift
+  if "$@" -S -o /dev/null demo.c >/dev/null 2>&1; then
+    measure "$label" "$@"
+  fi
+}
+
+# prints one row per function: mode name insns branches calls callees
+# and writes the instructions of each to $dir/$mode.$name.s for llvm-mca
+measure() {
+  mode=$1
+  shift
+  "$@" -S -Os -o "$dir/$mode.s" demo.c
+  awk -v mode="$mode" -v dir="$dir" '
+    /^ckd_[a-z_]*:/ {
+      name = substr($1, 1, length($1) - 1)
+      insns = branches = calls = 0
+      callees = ""
+      next
+    }
+    name && /^\t\.cfi_endproc|^\t\.size/ {
+      printf "%s %s %d %d %d %s\n", mode, name, insns, branches, calls,
+             callees == "" ? "-" : callees
+      close(dir "/" mode "." name ".s")
+      name = ""
+      next
+    }
+    name && /^\t[a-z]/ {
+      print > (dir "/" mode "." name ".s")
+      ++insns
+      if ($1 ~ /^j/) {
+        ++branches
+      }
+      if ($1 ~ /^call/) {
+        ++calls
+        callees = callees == "" ? $2 : callees ";" $2
+      }
+    }
+  ' "$dir/$mode.s" | while read -r mode name insns branches calls callees; do
+    rt=-
+    triple=x86_64
+    case $mode in
+      *-m32) triple=i386 ;;
+    esac
+    if [ "$mca" ]; then
+      rt=$($mca -mtriple=$triple -mcpu=x86-64 "$dir/$mode.$name.s" 2>/dev/null |
+           awk '/Block RThroughput/ { print $3 }')
+    fi
+    echo "$mode $name $insns $branches $calls ${rt:--} $callees"
+  done
+}
+
+{
+  echo "# mode function insns branches calls rthroughput callees"
+  echo "# $(cc --version | head -n 1)"
+  if [ "$mca" ]; then
+    echo "# $($mca --version | grep -i 'llvm version' | sed 's/^ *//')"
+  fi
+  measure builtins cc -DJTCKDINT_OPTION_STDCKDINT=2
+  measure c11 cc -std=c11 -DJTCKDINT_OPTION_STDCKDINT=2
+  measure c11-flags cc -std=c11 -DJTCKDINT_OPTION_STDCKDINT=2 \
+    -DJTCKDINT_OPTION_FLAGS=1
+  measure c++11 c++ -std=c++11 -xc++ -DJTCKDINT_OPTION_STDCKDINT=2
+  measure c++11-flags c++ -std=c++11 -xc++ -DJTCKDINT_OPTION_STDCKDINT=2 \
+    -DJTCKDINT_OPTION_FLAGS=1
+  maybe builtins-m32 cc -m32 -DJTCKDINT_OPTION_STDCKDINT=2
+  maybe c11-m32 cc -m32 -std=c11 -DJTCKDINT_OPTION_STDCKDINT=2
+  maybe c++11-m32 c++ -m32 -std=c++11 -xc++ -DJTCKDINT_OPTION_STDCKDINT=2
+  if echo '#include <stdckdint.h>' | cc -std=c2x -E -xc - >/dev/null 2>&1; then
+    measure stdckdint cc -std=c2x -DJTCKDINT_OPTION_STDCKDINT=1
+  fi
+} >"$dir/current"
+
+if [ "$1" = -u ]; then
+  cp "$dir/current" $golden
+  exit
+fi
+
+if ! diff -q "$dir/current" $golden >/dev/null 2>&1 \
+    && [ "$(sed -n 2p "$dir/current")" != "$(sed -n 2p $golden)" ]; then
+  echo "note: $golden was generated by a different compiler" >&2
+fi
+
+# Rows are matched by mode and function. A row that's missing, or has
+# more of anything than before, is a regression. The throughput is only
+# compared when both files have it, since llvm-mca may not be installed.
+awk '
+  /^#/ {
+    next
+  }
+  FILENAME == ARGV[1] {
+    golden[$1 " " $2] = $0
+    next
+  }
+  {
+    key = $1 " " $2
+    if (!(key in golden)) {
+      print "new:    " $0
+      next
+    }
+    split(golden[key], g)
+    delete golden[key]
+    worse = $3 > g[3] || $4 > g[4] || $5 > g[5] \
+         || $6 != "-" && g[6] != "-" && $6 + 0 > g[6] + 0.001
+    better = $3 < g[3] || $4 < g[4] || $5 < g[5] \
+          || $6 != "-" && g[6] != "-" && $6 + 0 < g[6] - 0.001
+    if (worse) {
+      print "worse:  " $0
+      print "    was " golden_line(g)
+      failed = 1
+    } else if (better) {
+      print "better: " $0
+    }
+  }
+  function golden_line(g,    s, i) {
+    s = g[1]
+    for (i = 2; i in g; ++i) {
+      s = s " " g[i]
+    }
+    return s
+  }
+  END {
+    for (key in golden) {
+      print "gone:   " golden[key]
+      failed = 1
+    }
+    if (failed) {
+      print "codegen regressed, see above, or run ./codegen.sh -u" \
+            " if this is intended"
+      exit 1
+    }
+  }
+' $golden "$dir/current"
@@ -0,0 +1,48 @@
+#!/bin/sh
+# measures how long a translation unit using jtckdint.h takes to compile
+# usage: ./compile.sh [iterations]
+
+set -e
+
+n=${1:-20}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+cp jtckdint.h jtckdint.cppm demo.c "$dir"
+cd "$dir"
+: >empty.c
+sed 's/#include "jtckdint.h"/import jtckdint;/' demo.c >import.cc
+
+bench() {
+  label=$1
+  shift
+  i=0
+  start=$(date +%s%N)
+  while [ $i -lt $n ]; do
+    "$@" -c -o /dev/null
+    i=$((i + 1))
+  done
+  end=$(date +%s%N)
+  printf '%-20s %8d us per tu\n' "$label" $(((end - start) / n / 1000))
+}
+
+echo
+echo ========================================================================
+echo jtckdint.h compile time of demo.c, averaged over $n runs
+echo ========================================================================
+echo
+
+bench "empty c" cc empty.c
+bench "builtins" cc demo.c
+bench "c11" cc -std=c11 demo.c
+cc -std=c11 -xc-header -o jtckdint.h.gch jtckdint.h
+bench "c11 pch" cc -std=c11 demo.c
+rm jtckdint.h.gch
+
+bench "empty c++" c++ -xc++ empty.c
+bench "c++11" c++ -std=c++11 -xc++ demo.c
+c++ -std=c++11 -xc++-header -o jtckdint.h.gch jtckdint.h
+bench "c++11 pch" c++ -std=c++11 -xc++ demo.c
+rm jtckdint.h.gch
+bench "c++20" c++ -std=c++20 -xc++ demo.c
+c++ -std=c++20 -fmodules-ts -c -x c++ -o jtckdint.o jtckdint.cppm
+bench "c++20 module" c++ -std=c++20 -fmodules-ts import.cc
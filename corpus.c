@@ -23,9 +23,14 @@
 #  error "Need __int128 and GCC builtins to generate 'test.bin'"
 #endif
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #if CHAR_BIT != 8
 #  error "CHAR_BIT is not 8"
@@ -127,8 +132,75 @@ FOR_TYPES(X)
 #undef Y
 #undef Z
 
+// The file starts with a header, followed by an index with an entry
+// for each result type, which says where its section of records is, so
+// they can be checked in parallel. Integers are big endian.
+//
+//   magic     8 bytes  "JTCKDINT"
+//   version   4 bytes  2
+//   sections  4 bytes  number of index entries
+//
+// Followed by an entry for each section:
+//
+//   type      4 bytes  sizeof(T) | is_signed << 7
+//   records   4 bytes  number of records
+//   offset    8 bytes  position of the first record in the file
+//   size      8 bytes  length of the records in bytes
+//
+// Each record is a tag byte, whose low six bits are sizeof(T), bit six
+// is the overflow flag, and bit seven says if an operand or the result
+// is 128 bits wide. Then the result follows in sizeof(T) bytes.
+
+#define VERSION 2
+#define HEADER 16
+#define ENTRY 24
+
 static FILE* reference;
 static u8 buffer[1 + sizeof(u128)];
+static u8 header[HEADER + ENTRY * 10];
+static i32 sections;
+static u32 records;
+static long start;
+
+static void put(u8* p, u64 x, i32 n)
+{
+  while (n--) {
+    p[n] = (u8)(x & 0xFF);
+    x >>= 8;
+  }
+}
+
+static void begin_section(u32 type)
+{
+  assert((start = ftell(reference)) != -1);
+  records = 0;
+  put(header + HEADER + sections * ENTRY, type, 4);
+}
+
+static void end_section(void)
+{
+  long end = ftell(reference);
+  u8* p = header + HEADER + sections++ * ENTRY;
+  assert(end != -1);
+  put(p + 4, records, 4);
+  put(p + 8, (u64)start, 8);
+  put(p + 16, (u64)(end - start), 8);
+}
+
+static void write_header(void)
+{
+  header[0] = 'J';
+  header[1] = 'T';
+  header[2] = 'C';
+  header[3] = 'K';
+  header[4] = 'D';
+  header[5] = 'I';
+  header[6] = 'N';
+  header[7] = 'T';
+  put(header + 8, VERSION, 4);
+  put(header + 12, (u64)sections, 4);
+  assert(fwrite(header, 1, sizeof(header), reference) == sizeof(header));
+}
 
 #define output_next(T, op, is_int128) \
   do { \
@@ -148,6 +220,7 @@ static u8 buffer[1 + sizeof(u128)];
     buffer[--index] = (u8)(((is_int128) << 7) | (o << 6) | (u8)sizeof(T)); \
     to_write = (u32)(sizeof(buffer) - index); \
     assert(fwrite(buffer + index, 1, to_write, reference) == to_write); \
+    ++records; \
   } while (0)
 
 #define M(T, U, V, I) \
@@ -201,17 +274,293 @@ MMM(i32, 0)
 MMM(i64, 0)
 MMM(i128, 1)
 
+// Passing a seed and a size instead writes random.bin, with about that
+// many bytes of random operations, whose operands are biased towards
+// the edges of their types. It's a stream of independent chunks, each
+// generated by its own thread, so only the results need to be written,
+// since the verifier can generate the same operands from the seed.
+//
+//   magic     8 bytes  "JTCKDRND"
+//   version   4 bytes  1
+//   seed      8 bytes
+//
+// Followed by chunks, and then a chunk with zero records:
+//
+//   size      4 bytes  length of the records in bytes
+//   records   4 bytes  number of records
+//
+// Each record holds the overflow flag in bit zero, and the result as a
+// distance from zero (zigzag), min or max, whichever is closest, which
+// is said by bits one and two. The rest is a little endian varint: the
+// first byte holds four bits of the distance, and the others hold seven
+// bits, with the high bit of each byte saying if another one follows.
+// Only 8 to 64 bit types are generated.
+
+#define STREAM_VERSION 1
+#define STREAM_HEADER 20
+#define CHUNK 65536
+#define CASES (3 * 8 * 8 * 8)
+
+static i32 const kBits[8] = {8, 16, 32, 64, 8, 16, 32, 64};
+static i32 const kSigned[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+static u64 next(u64* s)
+{
+  u64 z = (*s += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static u64 max_of(i32 t)
+{
+  return ~0ull >> (64 - kBits[t] + kSigned[t]);
+}
+
+static u64 min_of(i32 t)
+{
+  return kSigned[t] ? ~max_of(t) : 0;
+}
+
+// Picks zero, max, a power of two, its square root, or a number with a
+// random width, nudges it by up to two, maybe negates it, and then wraps
+// it to the type, so most operations are close to overflowing.
+static u64 pick(u64* s, i32 t)
+{
+  u64 x;
+  u64 r = next(s);
+  i32 bits = kBits[t];
+  switch (r & 7) {
+    case 0:
+      x = 0;
+      break;
+    case 1:
+      x = max_of(t);
+      break;
+    case 2:
+      x = 1ull << (r >> 8) % bits;
+      break;
+    case 3:
+      x = 1ull << bits / 2;
+      break;
+    default:
+      x = next(s) >> (r >> 8) % 64;
+      break;
+  }
+  x += (r >> 16) % 5 - 2;
+  if (r >> 24 & 1) {
+    x = -x;
+  }
+  if (bits < 64) {
+    x &= ~(~0ull << bits);
+    if (kSigned[t] && (x >> (bits - 1) & 1)) {
+      x |= ~0ull << bits;
+    }
+  }
+  return x;
+}
+
+static u64 chunk_seed(u64 seed, u64 chunk)
+{
+  u64 s = seed ^ chunk * 0xd1342543de82ef95ull;
+  return next(&s);
+}
+
+#define R(F, op, T, U, V) F(op, T, U, V)
+#define RM(F, op, T, U) \
+  R(F, op, T, U, u8) \
+  R(F, op, T, U, u16) \
+  R(F, op, T, U, u32) \
+  R(F, op, T, U, u64) \
+  R(F, op, T, U, i8) \
+  R(F, op, T, U, i16) \
+  R(F, op, T, U, i32) \
+  R(F, op, T, U, i64)
+#define RMM(F, op, T) \
+  RM(F, op, T, u8) \
+  RM(F, op, T, u16) \
+  RM(F, op, T, u32) \
+  RM(F, op, T, u64) \
+  RM(F, op, T, i8) \
+  RM(F, op, T, i16) \
+  RM(F, op, T, i32) \
+  RM(F, op, T, i64)
+#define RMMM(F, op) \
+  RMM(F, op, u8) \
+  RMM(F, op, u16) \
+  RMM(F, op, u32) \
+  RMM(F, op, u64) \
+  RMM(F, op, i8) \
+  RMM(F, op, i16) \
+  RMM(F, op, i32) \
+  RMM(F, op, i64)
+#define FOR_CASES(F) RMMM(F, add) RMMM(F, sub) RMMM(F, mul)
+
+#define F(op, T, U, V) \
+  static i32 op##_##T##_##U##_##V(u64 a, u64 b, u64* z) \
+  { \
+    T r = 0; \
+    i32 o = __builtin_##op##_overflow((U)a, (V)b, &r); \
+    *z = (u64)r; \
+    return o; \
+  }
+FOR_CASES(F)
+#undef F
+
+static i32 (*const kCases[CASES])(u64, u64, u64*) = {
+#define F(op, T, U, V) op##_##T##_##U##_##V,
+    FOR_CASES(F)
+#undef F
+};
+
+static u8* encode(u8* p, u64 z, i32 o, i32 t)
+{
+  u64 d = z << 1 ^ (u64)((i64)z >> 63);
+  u64 d1 = z - min_of(t);
+  u64 d2 = max_of(t) - z;
+  i32 anchor = 0;
+  if (d1 < d) {
+    d = d1;
+    anchor = 1;
+  }
+  if (d2 < d) {
+    d = d2;
+    anchor = 2;
+  }
+  *p = (u8)((d & 15) << 3 | anchor << 1 | o);
+  d >>= 4;
+  while (d) {
+    *p++ |= 0x80;
+    *p = (u8)(d & 127);
+    d >>= 7;
+  }
+  return p + 1;
+}
+
+struct chunk
+{
+  u64 seed;
+  u64 index;
+  u8* data;
+  u32 size;
+  pthread_t th;
+};
+
+static void* generate(void* arg)
+{
+  u32 k;
+  struct chunk* c = (struct chunk*)arg;
+  u64 s = chunk_seed(c->seed, c->index);
+  u8* p = c->data;
+  for (k = 0; k < CHUNK; ++k) {
+    u64 z;
+    u32 n = (u32)(next(&s) % CASES);
+    u64 a = pick(&s, n / 8 % 8);
+    u64 b = pick(&s, n % 8);
+    i32 o = kCases[n](a, b, &z);
+    p = encode(p, z, o, n / 64 % 8);
+  }
+  c->size = (u32)(p - c->data);
+  return 0;
+}
+
+static void write_stream(u64 seed, u64 target)
+{
+  i32 k;
+  u8 head[STREAM_HEADER];
+  u64 index = 0;
+  u64 written = STREAM_HEADER;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  i32 threads = cpus > 0 ? (i32)cpus : 1;
+  struct chunk* c = (struct chunk*)calloc(threads, sizeof(struct chunk));
+  assert(c);
+  assert(reference = fopen("random.bin", "wb"));
+  put(head, 0, 8);
+  head[0] = 'J';
+  head[1] = 'T';
+  head[2] = 'C';
+  head[3] = 'K';
+  head[4] = 'D';
+  head[5] = 'R';
+  head[6] = 'N';
+  head[7] = 'D';
+  put(head + 8, STREAM_VERSION, 4);
+  put(head + 12, seed, 8);
+  assert(fwrite(head, 1, sizeof(head), reference) == sizeof(head));
+  for (k = 0; k < threads; ++k) {
+    assert(c[k].data = (u8*)malloc(CHUNK * 10));
+    c[k].seed = seed;
+  }
+  while (written < target) {
+    for (k = 0; k < threads; ++k) {
+      c[k].index = index++;
+      assert(!pthread_create(&c[k].th, 0, generate, &c[k]));
+    }
+    for (k = 0; k < threads; ++k) {
+      assert(!pthread_join(c[k].th, 0));
+      if (written >= target) {
+        continue;
+      }
+      put(head, c[k].size, 4);
+      put(head + 4, CHUNK, 4);
+      assert(fwrite(head, 1, 8, reference) == 8);
+      assert(fwrite(c[k].data, 1, c[k].size, reference) == c[k].size);
+      written += 8 + c[k].size;
+    }
+  }
+  put(head, 0, 8);
+  assert(fwrite(head, 1, 8, reference) == 8);
+  assert(fclose(reference) == 0);
+  for (k = 0; k < threads; ++k) {
+    free(c[k].data);
+  }
+  free(c);
+}
+
+// Parses a size like 100m or 4g.
+static u64 parse_size(char const* s)
+{
+  char* end;
+  u64 x = strtoull(s, &end, 0);
+  switch (*end | 32) {
+    case 'g':
+      x <<= 10;
+      /* fallthrough */
+    case 'm':
+      x <<= 10;
+      /* fallthrough */
+    case 'k':
+      x <<= 10;
+      break;
+    default:
+      break;
+  }
+  return x;
+}
+
 int main(int argc, char* argv[])
 {
-  (void)argc;
-  (void)argv;
+  if (argc == 3) {
+    write_stream(strtoull(argv[1], 0, 0), parse_size(argv[2]));
+    return 0;
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [seed size]\n", argv[0]);
+    return 1;
+  }
 
   assert(reference = fopen("test.bin", "wb"));
+  write_header();
 
-#define X(S, N) output_##S##N();
+#define X(S, N) \
+  begin_section(IF(SIGNED_##S)(0x80, 0) | (N / 8)); \
+  output_##S##N(); \
+  end_section();
   FOR_TYPES(X)
 #undef X
 
+  assert(fseek(reference, 0, SEEK_SET) == 0);
+  write_header();
+
   assert(fclose(reference) == 0);
   return 0;
 }
@@ -0,0 +1,123 @@
+// run ./count.sh
+
+#include "jtckdint.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+#  define cast(T, x) (static_cast<T>(x))
+#else
+#  define cast(T, x) ((T)(x))
+#endif
+
+// Each function is called between two SIGSTOP signals and single stepped
+// by the parent process, which counts the instructions in between. Hence
+// these counts are exact, and don't need access to performance counters.
+
+#define FOR_CASES(F) \
+  F(add, unsigned long, unsigned long, unsigned long, add_ulong_ulong_ulong) \
+  F(add, signed long, signed long, signed long, add_long_long_long) \
+  F(add, unsigned long, signed long, signed long, add_ulong_long_long) \
+  F(add, signed int, signed int, signed int, add_int_int_int) \
+  F(sub, unsigned long, unsigned long, unsigned long, sub_ulong_ulong_ulong) \
+  F(sub, signed long, signed long, signed long, sub_long_long_long) \
+  F(sub, unsigned long, signed long, signed long, sub_ulong_long_long) \
+  F(sub, signed int, signed int, signed int, sub_int_int_int) \
+  F(mul, unsigned long, unsigned long, unsigned long, mul_ulong_ulong_ulong) \
+  F(mul, signed long, signed long, signed long, mul_long_long_long) \
+  F(mul, unsigned long, signed long, signed long, mul_ulong_long_long) \
+  F(mul, signed int, signed int, signed int, mul_int_int_int)
+
+static volatile long x = 123;
+static volatile long y = 45;
+static volatile int sink;
+
+static void baseline(void)
+{
+  sink = cast(int, x + y);
+}
+
+#define F(op, T, U, V, S) \
+  static void S(void) \
+  { \
+    T z; \
+    sink = ckd_##op(&z, cast(U, x), cast(V, y)); \
+  }
+FOR_CASES(F)
+#undef F
+
+static struct
+{
+  char const* name;
+  void (*func)(void);
+} const kCases[] = {
+    {"baseline", baseline},
+#define F(op, T, U, V, S) {#S, S},
+    FOR_CASES(F)
+#undef F
+};
+
+static void (*volatile call)(void);
+
+static int wait_for(pid_t pid)
+{
+  int ws = 0;
+  if (waitpid(pid, &ws, 0) != pid || !WIFSTOPPED(ws)) {
+    return -1;
+  }
+  return WSTOPSIG(ws);
+}
+
+int main(int argc, char* argv[])
+{
+  size_t i;
+  long base = 0;
+  size_t n = sizeof(kCases) / sizeof(kCases[0]);
+  pid_t pid = fork();
+  if (!pid) {
+    ptrace(PTRACE_TRACEME, 0, 0, 0);
+    raise(SIGSTOP);
+    for (i = 0; i < n; ++i) {
+      call = kCases[i].func;
+      raise(SIGSTOP);
+      call();
+      raise(SIGSTOP);
+    }
+    _exit(0);
+  }
+  if (wait_for(pid) != SIGSTOP) {
+    return 1;
+  }
+  ptrace(PTRACE_CONT, pid, 0, 0);
+  for (i = 0; i < n; ++i) {
+    long count = 0;
+    if (wait_for(pid) != SIGSTOP) {
+      return 1;
+    }
+    for (;;) {
+      int sig;
+      ptrace(PTRACE_SINGLESTEP, pid, 0, 0);
+      if ((sig = wait_for(pid)) == SIGSTOP) {
+        break;
+      } else if (sig != SIGTRAP) {
+        return 1;
+      }
+      ++count;
+    }
+    if (!i) {
+      base = count;
+    } else {
+      printf("%-8s %-24s %4ld\n",
+             argc > 1 ? argv[1] : "",
+             kCases[i].name,
+             count - base);
+    }
+    ptrace(PTRACE_CONT, pid, 0, 0);
+  }
+  return wait_for(pid) != -1;
+}
@@ -0,0 +1,23 @@
+#!/bin/sh
+# prints how many instructions each checked operation executes per call
+
+set -e
+
+run() {
+  label=$1
+  shift
+  "$@" $opt -o count count.c
+  ./count $label
+}
+
+for opt in -O0 -Og; do
+  echo
+  echo ========================================================================
+  echo jtckdint.h instructions per call at $opt
+  echo ========================================================================
+  echo
+  run builtins cc
+  run c11 cc -std=c11
+  run c++11 c++ -std=c++11 -xc++
+done
+rm -f count
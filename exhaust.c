@@ -0,0 +1,278 @@
+// run make exhaust && ./exhaust [bits [threads]]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "jtckdint.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+#  define cast(T, x) (static_cast<T>(x))
+#  define EXTERN_C extern "C"
+#else
+#  define cast(T, x) ((T)(x))
+#  define EXTERN_C
+#endif
+
+// This file is compiled once for each backend, with BACKEND defined to
+// its name, and once more without it for the driver, and then they're
+// all linked together. Each backend computes every 8 and 16 bit result
+// for one row of operands at a time, which the driver compares in
+// memory, so every combination is covered and there's no test.bin.
+
+#define XCAT(x, y) x##y
+#define CAT(x, y) XCAT(x, y)
+
+#define FOR_BACKENDS(F) \
+  F(builtins) \
+  F(c11) \
+  F(cxx11)
+
+typedef int8_t i8;
+typedef uint8_t u8;
+typedef int16_t i16;
+typedef uint16_t u16;
+typedef int32_t i32;
+
+/* clang-format off */
+#define TYPES(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16)
+
+// each nesting level needs its own copy, since macros can't recurse
+#define TYPES_U(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16)
+
+#define TYPES_V(F, ...) \
+  F(__VA_ARGS__, u8) \
+  F(__VA_ARGS__, u16) \
+  F(__VA_ARGS__, i8) \
+  F(__VA_ARGS__, i16)
+/* clang-format on */
+
+#define EACH_V(F, op, T, U) TYPES_V(F, op, T, U)
+#define EACH_U(F, op, T) TYPES_U(EACH_V, F, op, T)
+#define EACH_T(F, op) TYPES(EACH_U, F, op)
+#define FOR_CASES(F) EACH_T(F, add) EACH_T(F, sub) EACH_T(F, mul)
+
+#ifdef BACKEND
+
+// Results are stored as twice the value plus the overflow flag.
+#  define CASE(op, T, U, V) \
+    static void op##_##T##_##U##_##V(unsigned a, unsigned n, i32* z) \
+    { \
+      unsigned b; \
+      U x = cast(U, a); \
+      for (b = 0; b < n; ++b) { \
+        T r; \
+        bool o = ckd_##op(&r, x, cast(V, b)); \
+        z[b] = cast(i32, r) * 2 + o; \
+      } \
+    }
+FOR_CASES(CASE)
+#  undef CASE
+
+static void (*const kCases[])(unsigned, unsigned, i32*) = {
+#  define CASE(op, T, U, V) op##_##T##_##U##_##V,
+    FOR_CASES(CASE)
+#  undef CASE
+};
+
+EXTERN_C void CAT(exhaust_, BACKEND)(size_t, unsigned, unsigned, i32*);
+
+EXTERN_C void CAT(exhaust_, BACKEND)(size_t c, unsigned a, unsigned n,
+                                     i32* z)
+{
+  kCases[c](a, n, z);
+}
+
+#else
+
+#  include <pthread.h>
+#  include <string.h>
+#  include <time.h>
+#  include <unistd.h>
+
+#  define X(B) void exhaust_##B(size_t, unsigned, unsigned, i32*);
+FOR_BACKENDS(X)
+#  undef X
+
+static struct
+{
+  char const* name;
+  void (*run)(size_t, unsigned, unsigned, i32*);
+} const kBackends[] = {
+#  define X(B) {#B, exhaust_##B},
+    FOR_BACKENDS(X)
+#  undef X
+};
+
+#  define BACKENDS (sizeof(kBackends) / sizeof(kBackends[0]))
+
+static struct
+{
+  char const* op;
+  char const* t;
+  char const* u;
+  char const* v;
+  unsigned ubits;
+  unsigned vbits;
+} const kCases[] = {
+#  define CASE(op, T, U, V) \
+    {#op, #T, #U, #V, sizeof(U) * 8, sizeof(V) * 8},
+    FOR_CASES(CASE)
+#  undef CASE
+};
+
+#  define CASES (sizeof(kCases) / sizeof(kCases[0]))
+
+static unsigned bits;
+static unsigned threads;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static bool failed;
+
+static bool stopped(void)
+{
+  bool o;
+  pthread_mutex_lock(&lock);
+  o = failed;
+  pthread_mutex_unlock(&lock);
+  return o;
+}
+
+static void report_mismatch(size_t c, unsigned a, unsigned b, i32 const* z,
+                            unsigned n)
+{
+  size_t k;
+  pthread_mutex_lock(&lock);
+  if (!failed) {
+    failed = true;
+    fprintf(stderr,
+            "Mismatch: ckd_%s(%s, %s %u, %s %u)\n",
+            kCases[c].op,
+            kCases[c].t,
+            kCases[c].u,
+            a,
+            kCases[c].v,
+            b);
+    for (k = 0; k < BACKENDS; ++k) {
+      i32 x = z[k * n + b];
+      fprintf(stderr,
+              "  %-8s (%d) %ld\n",
+              kBackends[k].name,
+              cast(int, x & 1),
+              cast(long, (x - (x & 1)) / 2));
+    }
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+// Returns the first operand where some backend disagrees, or n.
+static unsigned compare(i32 const* z, unsigned n)
+{
+  size_t k;
+  unsigned b;
+  for (k = 1; k < BACKENDS; ++k) {
+    if (memcmp(z, z + k * n, n * sizeof(i32))) {
+      for (b = 0; z[b] == z[k * n + b]; ++b) {
+      }
+      return b;
+    }
+  }
+  return n;
+}
+
+// Each thread takes every nth row of operands of each case.
+static void* worker(void* arg)
+{
+  size_t c, k;
+  unsigned a, b;
+  unsigned first = cast(unsigned, cast(size_t, arg));
+  i32* z = cast(i32*, malloc(BACKENDS * 65536 * sizeof(i32)));
+  if (!z) {
+    perror("malloc");
+    exit(1);
+  }
+  for (c = 0; c < CASES && !stopped(); ++c) {
+    unsigned rows = 1u << kCases[c].ubits;
+    unsigned n = 1u << kCases[c].vbits;
+    if (kCases[c].ubits > bits || kCases[c].vbits > bits) {
+      continue;
+    }
+    for (a = first; a < rows && !stopped(); a += threads) {
+      for (k = 0; k < BACKENDS; ++k) {
+        kBackends[k].run(c, a, n, z + k * n);
+      }
+      if ((b = compare(z, n)) != n) {
+        report_mismatch(c, a, b, z, n);
+        break;
+      }
+    }
+  }
+  free(z);
+  return 0;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return cast(double, ts.tv_sec) + cast(double, ts.tv_nsec) * 1e-9;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t c, k;
+  double ops = 0;
+  double start, secs;
+  pthread_t* th;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  bits = argc > 1 ? cast(unsigned, atoi(argv[1])) : 16;
+  threads = argc > 2 ? cast(unsigned, atoi(argv[2]))
+                     : cast(unsigned, cpus > 0 ? cpus : 1);
+  if ((bits != 8 && bits != 16) || !threads) {
+    fprintf(stderr, "usage: %s [8|16 [threads]]\n", argv[0]);
+    return 1;
+  }
+  for (c = 0; c < CASES; ++c) {
+    if (kCases[c].ubits <= bits && kCases[c].vbits <= bits) {
+      ops += cast(double, 1u << kCases[c].ubits) * (1u << kCases[c].vbits);
+    }
+  }
+  if (!(th = cast(pthread_t*, malloc(threads * sizeof(pthread_t))))) {
+    perror("malloc");
+    return 1;
+  }
+  start = now();
+  for (k = 0; k < threads; ++k) {
+    if (pthread_create(&th[k], 0, worker, cast(void*, k))) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+  for (k = 0; k < threads; ++k) {
+    pthread_join(th[k], 0);
+  }
+  secs = now() - start;
+  free(th);
+  if (failed) {
+    return 1;
+  }
+  printf("%.0f operations on %u threads with each of %u backends agree\n",
+         ops,
+         threads,
+         cast(unsigned, BACKENDS));
+  printf("%.3f seconds, %.0f ops/second\n",
+         secs,
+         ops * BACKENDS / secs);
+  return 0;
+}
+
+#endif
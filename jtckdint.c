@@ -0,0 +1,360 @@
+/*
+ * Copyright 2023 Justine Alexandra Roberts Tunney
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * @fileoverview Out-of-line ckd_add, ckd_sub and ckd_mul for libjtckdint.a
+ *
+ * Code built with -DJTCKDINT_OPTION_LIBRARY=1 calls the functions this
+ * file defines, instead of inlining them. It's compiled once as C, and
+ * once as C++, which `make lib` does:
+ *
+ *     cc -c -o jtckdint.o jtckdint.c
+ *     c++ -xc++ -c -o jtckdint++.o jtckdint.c
+ *     ar rcs libjtckdint.a jtckdint.o jtckdint++.o
+ *
+ * The compiler builtins are used whenever they're available, even in
+ * strict modes, since this is the only place they're expanded.
+ *
+ * The C object also holds the per-thread tables and csv writer used by
+ * -DJTCKDINT_OPTION_STATS=1, which must be linked with this library.
+ */
+
+#define JTCKDINT_OPTION_LIBRARY 1
+#define JTCKDINT_OPTION_STATS 1
+/* for the 64-bit lanes of the polyfill, when there are no builtins */
+#define JTCKDINT_OPTION_EXTRAS 1
+#include "jtckdint.h"
+
+#if defined(__GNUC__) && __GNUC__ >= 5 && !defined(__ICC) \
+    || ckd_has_builtin(__builtin_add_overflow) \
+        && ckd_has_builtin(__builtin_sub_overflow) \
+        && ckd_has_builtin(__builtin_mul_overflow)
+#  define ckd_lib_builtins
+#endif
+
+#if defined(ckd_have_templates)
+
+#  ifdef ckd_lib_builtins
+
+template<typename T, typename U, typename V>
+bool ckd_lib_add(T* res, U a, V b)
+{
+  return __builtin_add_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+bool ckd_lib_sub(T* res, U a, V b)
+{
+  return __builtin_sub_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+bool ckd_lib_mul(T* res, U a, V b)
+{
+  return __builtin_mul_overflow(a, b, res);
+}
+
+#  else
+
+template<typename T, typename U, typename V>
+bool ckd_lib_add(T* res, U a, V b)
+{
+  return ckd_lane_add(ckd_case<ckd_add_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+bool ckd_lib_sub(T* res, U a, V b)
+{
+  return ckd_lane_sub(
+      ckd_case<ckd_add_case<ckd_uintmax, T, U, V, true>::value>(),
+      res,
+      static_cast<ckd_uintmax>(a),
+      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+bool ckd_lib_mul(T* res, U a, V b)
+{
+  return ckd_lane_mul(ckd_case<ckd_mul_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+#  endif
+
+#  ifdef ckd_have_int128
+#    define ckd_lib_int128(F) F
+#  else
+#    define ckd_lib_int128(F) ckd_lib_eat
+#  endif
+#  define ckd_lib_eat(...)
+
+/* clang-format off */
+// each nesting level needs its own copy, since macros can't recurse
+#  define ckd_lib_t(F) \
+    F(signed char) F(unsigned char) \
+    F(short) F(unsigned short) \
+    F(int) F(unsigned) \
+    F(long) F(unsigned long) \
+    F(long long) F(unsigned long long) \
+    ckd_lib_int128(F)(signed __int128) \
+    ckd_lib_int128(F)(unsigned __int128)
+#  define ckd_lib_u(F, T) \
+    F(T, signed char) F(T, unsigned char) \
+    F(T, short) F(T, unsigned short) \
+    F(T, int) F(T, unsigned) \
+    F(T, long) F(T, unsigned long) \
+    F(T, long long) F(T, unsigned long long) \
+    ckd_lib_int128(F)(T, signed __int128) \
+    ckd_lib_int128(F)(T, unsigned __int128)
+#  define ckd_lib_v(F, T, U) \
+    F(T, U, signed char) F(T, U, unsigned char) \
+    F(T, U, short) F(T, U, unsigned short) \
+    F(T, U, int) F(T, U, unsigned) \
+    F(T, U, long) F(T, U, unsigned long) \
+    F(T, U, long long) F(T, U, unsigned long long) \
+    ckd_lib_int128(F)(T, U, signed __int128) \
+    ckd_lib_int128(F)(T, U, unsigned __int128)
+/* clang-format on */
+
+#  define ckd_lib_instantiate(T, U, V) \
+    template bool ckd_lib_add(T*, U, V); \
+    template bool ckd_lib_sub(T*, U, V); \
+    template bool ckd_lib_mul(T*, U, V);
+#  define ckd_lib_each_v(T, U) ckd_lib_v(ckd_lib_instantiate, T, U)
+#  define ckd_lib_each_u(T) ckd_lib_u(ckd_lib_each_v, T)
+ckd_lib_t(ckd_lib_each_u)
+
+#elif defined(ckd_have_generic)
+
+// The operands arrive widened to L, so SL recovers the value of the
+// signed ones. The builtins then see the original values and T.
+#  ifdef ckd_lib_builtins
+#    define ckd_lib_define(name, F, op, T, L, SL) \
+      bool name(void* res, L x, L y, unsigned char ab_signed) \
+      { \
+        switch (ab_signed) { \
+          case 0: \
+            return __builtin_##op##_overflow(x, y, (T*)res); \
+          case 1: \
+            return __builtin_##op##_overflow(x, (SL)y, (T*)res); \
+          case 2: \
+            return __builtin_##op##_overflow((SL)x, y, (T*)res); \
+          default: \
+            return __builtin_##op##_overflow((SL)x, (SL)y, (T*)res); \
+        } \
+      }
+#  else
+#    define ckd_lib_define(name, F, op, T, L, SL) \
+      bool name(void* res, L x, L y, unsigned char ab_signed) \
+      { \
+        return F(res, x, y, ab_signed); \
+      }
+#  endif
+
+/* clang-format off */
+#  define ckd_lib_each(F, L, SL, op) \
+    F(op, schar, signed char, L, SL) \
+    F(op, uchar, unsigned char, L, SL) \
+    F(op, sshort, signed short, L, SL) \
+    F(op, ushort, unsigned short, L, SL) \
+    F(op, sint, signed int, L, SL) \
+    F(op, uint, unsigned int, L, SL) \
+    F(op, slong, signed long, L, SL) \
+    F(op, ulong, unsigned long, L, SL) \
+    F(op, slonger, signed long long, L, SL) \
+    F(op, ulonger, unsigned long long, L, SL)
+/* clang-format on */
+
+#  ifdef ckd_have_int128
+#    define ckd_lib_define64(op, S, T, L, SL) \
+      ckd_lib_define(ckd_lib64(op, S), ckd_##op##64_##S, op, T, L, SL)
+#  else
+#    define ckd_lib_define64(op, S, T, L, SL) \
+      ckd_lib_define(ckd_lib64(op, S), ckd_##op##_##S, op, T, L, SL)
+#  endif
+ckd_lib_each(ckd_lib_define64, ckd_uint64, ckd_int64, add)
+ckd_lib_each(ckd_lib_define64, ckd_uint64, ckd_int64, sub)
+ckd_lib_each(ckd_lib_define64, ckd_uint64, ckd_int64, mul)
+
+#  ifdef ckd_have_int128
+#    define ckd_lib_define128(op, S, T, L, SL) \
+      ckd_lib_define(ckd_lib128(op, S), ckd_##op##_##S, op, T, L, SL)
+ckd_lib_each(ckd_lib_define128, ckd_uintmax, ckd_intmax, add)
+ckd_lib_each(ckd_lib_define128, ckd_uintmax, ckd_intmax, sub)
+ckd_lib_each(ckd_lib_define128, ckd_uintmax, ckd_intmax, mul)
+ckd_lib_define128(add, sint128, signed __int128, ckd_uintmax, ckd_intmax)
+ckd_lib_define128(add, uint128, unsigned __int128, ckd_uintmax, ckd_intmax)
+ckd_lib_define128(sub, sint128, signed __int128, ckd_uintmax, ckd_intmax)
+ckd_lib_define128(sub, uint128, unsigned __int128, ckd_uintmax, ckd_intmax)
+ckd_lib_define128(mul, sint128, signed __int128, ckd_uintmax, ckd_intmax)
+ckd_lib_define128(mul, uint128, unsigned __int128, ckd_uintmax, ckd_intmax)
+#  endif
+
+#endif
+
+#if defined(ckd_have_stats) && !defined(ckd_have_templates)
+#  include <stdatomic.h>
+#  include <stdio.h>
+#  include <stdlib.h>
+#  include <string.h>
+
+ckd_thread_local ckd_stats_table* ckd_stats_tls;
+
+// absorbs the calls of a thread whose table couldn't be allocated
+static ckd_thread_local ckd_stats_site ckd_stats_lost;
+
+// every table that was ever allocated, newest first
+static _Atomic(ckd_stats_table*) ckd_stats_all;
+
+static char const* ckd_stats_path;
+
+ckd_stats_site* ckd_stats_insert(char const* file, unsigned long long key)
+{
+  ckd_stats_table* t = ckd_stats_tls;
+  size_t h = ckd_stats_hash(file, key);
+  size_t i;
+  if (!t) {
+    if (!(t = (ckd_stats_table*)calloc(1, sizeof(*t)))) {
+      return &ckd_stats_lost;
+    }
+    t->next = atomic_load(&ckd_stats_all);
+    while (!atomic_compare_exchange_weak(&ckd_stats_all, &t->next, t)) {
+    }
+    ckd_stats_tls = t;
+  }
+  for (i = 0; i != ckd_stats_slots; ++i) {
+    ckd_stats_site* s = &t->site[(h + i) & (ckd_stats_slots - 1)];
+    if (!s->file) {
+      ckd_stats_store(s->key, key, RELAXED);
+      ckd_stats_store(s->file, file, RELEASE);
+      return s;
+    }
+    if (s->file == file && s->key == key) {
+      return s;
+    }
+  }
+  return &t->spill;
+}
+
+static int ckd_stats_cmp(void const* x, void const* y)
+{
+  ckd_stats_site const* a = (ckd_stats_site const*)x;
+  ckd_stats_site const* b = (ckd_stats_site const*)y;
+  int c = strcmp(a->file, b->file);
+  if (c) {
+    return c;
+  }
+  return a->key < b->key ? -1 : a->key > b->key;
+}
+
+static char const* ckd_stats_type_name(char* buf, unsigned t)
+{
+  sprintf(buf, "%c%u", t & 1 ? 'i' : 'u', t / 2 * 8);
+  return buf;
+}
+
+// Copies the sites of every thread, then sorts them, so the same site in
+// different threads, or __FILE__ strings of different translation units
+// that name the same file, are merged into one row.
+int ckd_stats_dump(char const* path)
+{
+  static char const op[3][4] = {"add", "sub", "mul"};
+  ckd_stats_table* all = atomic_load(&ckd_stats_all);
+  ckd_stats_table* t;
+  ckd_stats_site* v;
+  ckd_stats_site other = {"(other)", 0, 0, 0};
+  size_t i, j, n = 0;
+  FILE* f;
+  int rc = 0;
+  for (t = all; t; t = t->next) {
+    n += ckd_stats_slots;
+  }
+  if (!(v = (ckd_stats_site*)malloc((n ? n : 1) * sizeof(*v)))) {
+    return -1;
+  }
+  for (n = 0, t = all; t; t = t->next) {
+    for (i = 0; i != ckd_stats_slots; ++i) {
+      ckd_stats_site* s = &t->site[i];
+      if ((v[n].file = ckd_stats_load(s->file, ACQUIRE))) {
+        v[n].key = ckd_stats_load(s->key, RELAXED);
+        v[n].calls = ckd_stats_load(s->calls, RELAXED);
+        v[n].fails = ckd_stats_load(s->fails, RELAXED);
+        n += v[n].calls != 0;
+      }
+    }
+    other.calls += ckd_stats_load(t->spill.calls, RELAXED);
+    other.fails += ckd_stats_load(t->spill.fails, RELAXED);
+  }
+  qsort(v, n, sizeof(*v), ckd_stats_cmp);
+  if (!(f = path ? fopen(path, "w") : stderr)) {
+    free(v);
+    return -1;
+  }
+  fprintf(f, "file,line,op,type,a,b,calls,overflows\n");
+  for (i = 0; i != n; i = j) {
+    char t0[8], t1[8], t2[8];
+    unsigned long long calls = 0, fails = 0;
+    for (j = i; j != n && !ckd_stats_cmp(&v[i], &v[j]); ++j) {
+      calls += v[j].calls;
+      fails += v[j].fails;
+    }
+    fprintf(f,
+            "%s,%llu,%s,%s,%s,%s,%llu,%llu\n",
+            v[i].file,
+            v[i].key >> 32,
+            op[v[i].key >> 24 & 3],
+            ckd_stats_type_name(t0, v[i].key >> 16 & 255),
+            ckd_stats_type_name(t1, v[i].key >> 8 & 255),
+            ckd_stats_type_name(t2, v[i].key & 255),
+            calls,
+            fails);
+  }
+  if (other.calls) {
+    fprintf(f, "%s,0,,,,,%llu,%llu\n", other.file, other.calls, other.fails);
+  }
+  if (ferror(f)) {
+    rc = -1;
+  }
+  if (path ? fclose(f) : fflush(f)) {
+    rc = -1;
+  }
+  free(v);
+  return rc;
+}
+
+static void ckd_stats_exit(void)
+{
+  ckd_stats_dump(ckd_stats_path);
+}
+
+int ckd_stats_atexit(char const* path)
+{
+  static bool registered;
+  ckd_stats_path = path;
+  if (registered) {
+    return 0;
+  }
+  registered = true;
+  return atexit(ckd_stats_exit);
+}
+
+#endif
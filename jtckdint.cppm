@@ -0,0 +1,54 @@
+/*
+ * Copyright 2023 Justine Alexandra Roberts Tunney
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * @fileoverview C++20 module interface for jtckdint.h
+ *
+ * Translation units may say `import jtckdint;` instead of including the
+ * header, so it only gets parsed once, when this file is compiled:
+ *
+ *     g++ -std=c++20 -fmodules-ts -c -x c++ jtckdint.cppm
+ *
+ * The JTCKDINT_OPTION_* macros need to be defined when compiling this
+ * file, since importers can't see macros. In C++ ckd_add, ckd_sub and
+ * ckd_mul are templates with every backend, so that's all they need.
+ * The counting and tracing modes are the exception. They point those
+ * names at wrappers using macros, which importers wouldn't see, so they
+ * would silently count and trace nothing, and are rejected instead.
+ */
+
+module;
+
+#if defined(JTCKDINT_OPTION_STATS) && JTCKDINT_OPTION_STATS == 1
+#  error "JTCKDINT_OPTION_STATS=1 can't be exported by a module"
+#endif
+#if defined(JTCKDINT_OPTION_USDT) && JTCKDINT_OPTION_USDT == 1
+#  error "JTCKDINT_OPTION_USDT=1 can't be exported by a module"
+#endif
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#if __has_include(<span>)
+#  include <span>
+#endif
+
+export module jtckdint;
+
+export {
+#include "jtckdint.h"
+}
@@ -45,10 +45,82 @@
  * in the output type. Our example above did not result in an error due
  * to `0x80000001` being a legal value for `uint32_t`.
  *
+ * In C++14 and later these are `constexpr` with every backend, since
+ * the builtins, inline assembly and library calls give way to the
+ * polyfill during constant evaluation.
+ *
+ * Whole arrays may be checked at once using the span functions:
+ *
+ *   - `size_t ckd_add_n(res, a, b, n)`
+ *   - `size_t ckd_sub_n(res, a, b, n)`
+ *   - `size_t ckd_mul_n(res, a, b, n)`
+ *
+ * Which store all `n` results and return the index of the first lane
+ * that wasn't exact, or `n` if every lane fit. These always go through
+ * our polyfill bit hacks, because unlike the builtins they vectorize.
+ *
+ * There's also a pair of reductions:
+ *
+ *   - `bool ckd_sum(res, a, n)`
+ *   - `bool ckd_dot(res, a, b, n)`
+ *
+ * Which behave as though each term were accumulated into `*res` one by
+ * one, starting from zero, with the scalar functions.
+ *
+ * Buffer sizes are usually computed by fused functions:
+ *
+ *   - `bool ckd_muladd(res, a, b, c)` for `a * b + c`
+ *   - `bool ckd_muladd2(res, a, b, c, d, e)` for `a * b + c * d + e`
+ *
+ * Which check the exact result once, instead of each intermediate.
+ *
+ * Sticky contexts let many operations share one check:
+ *
+ *     ckd_ctx c;
+ *     ckd_ctx_init(&c);
+ *     ckd_ctx_add(&c, &end, off, len);
+ *     ckd_ctx_mul(&c, &bytes, count, size);
+ *     if (ckd_ctx_failed(&c)) return -1;
+ *
+ * Call sites that just give up may say `ckd_add_or_trap(res, a, b)`, or
+ * `ckd_add_or(res, a, b, handler)` to call a cold handler, which keeps
+ * the error path out of the way. The same goes for sub and mul.
+ *
+ * Saturating functions clamp the exact result instead of failing:
+ *
+ *   - `bool ckd_sat_add(res, a, b)`
+ *   - `bool ckd_sat_sub(res, a, b)`
+ *   - `bool ckd_sat_mul(res, a, b)`
+ *
+ * Which return true if clamping happened. Span versions are available
+ * too, e.g. `ckd_sat_add_n(res, a, b, n)`.
+ *
+ * C++ code may say `ckd_checked<int> z = a * b + c` where the operands
+ * are ckd_checked<T>, to check the whole expression once. Operands may
+ * also be ckd_bounded<T, Lo, Hi> in which case ckd_set(&z, a * b + c)
+ * only performs a check if the range of the expression might not fit.
+ *
+ * Big unsigned integers may be checked as arrays of limbs, e.g.
+ * `ckd_mul_limbs(z, zn, x, xn, y, yn)`, which uses a carry chain.
+ *
+ * N-dimensional array offsets may be validated once with ckd_shape_init()
+ * so that ckd_shape_offset() and ckd_shape_next() needn't be checked.
+ * Loops over `a + i * b` may be checked once with ckd_affine(z, a, b, n).
+ *
+ * C code only gets the span, reduction, muladd and saturating functions
+ * with -DJTCKDINT_OPTION_EXTRAS=1, since each is a function per type.
+ *
+ * Building with -DJTCKDINT_OPTION_STATS=1 counts the calls and overflows
+ * of each ckd_add, ckd_sub and ckd_mul call site, which ckd_stats_dump()
+ * writes as csv. With -DJTCKDINT_OPTION_USDT=1 each failure fires the
+ * jtckdint:overflow USDT probe, for bpftrace or perf to attach to.
+ *
  * This implementation will use the GNU compiler builtins, when they're
  * available, only if you don't use build flags like `-std=c11` because
  * they define `__STRICT_ANSI__` and GCC extensions aren't really ANSI.
  * Instead, you'll get a pretty good pure C11 and C++11 implementation.
+ * Those builds don't have __int128, so `ckd_i128` and `ckd_u128` are
+ * provided, which are two-limb structs unless __int128 is available.
  *
  * @see https://www.open-std.org/jtc1/sc22/wg14/www/docs/n3096.pdf
  * @version 0.1 (2023-07-22)
@@ -69,85 +141,121 @@
 #  define ckd_has_feature(x) 0
 #endif
 
-/**
- * JTCKDINT_OPTION_STDCKDINT
- *   = 0: detect <stdckdint.h>
- *   = 1: always use <stdckdint.h>
- *   = 2: never use <stdckdint.h>
- */
-#if defined(JTCKDINT_OPTION_STDCKDINT) && JTCKDINT_OPTION_STDCKDINT == 1 \
-    || (!defined(JTCKDINT_OPTION_STDCKDINT) || JTCKDINT_OPTION_STDCKDINT == 0) \
-        && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L \
-        && ckd_has_include(<stdckdint.h>)
-#  include <stdckdint.h>
+#ifdef __has_builtin
+#  define ckd_has_builtin(x) __has_builtin(x)
 #else
+#  define ckd_has_builtin(x) 0
+#endif
 
-#  if !defined(__STRICT_ANSI__) && defined(__SIZEOF_INT128__)
-#    define ckd_have_int128
-#    define ckd_longest __int128
-#  elif defined(__cplusplus) && __cplusplus >= 201103L \
-      || defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
-#    define ckd_longest long long
-#  else
-#    define ckd_longest long
-#  endif
+#if !defined(__STRICT_ANSI__) && defined(__SIZEOF_INT128__)
+#  define ckd_have_int128
+#  define ckd_longest __int128
+#elif defined(__cplusplus) && __cplusplus >= 201103L \
+    || defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#  define ckd_longest long long
+#else
+#  define ckd_longest long
+#endif
 
 typedef signed ckd_longest ckd_intmax;
 typedef unsigned ckd_longest ckd_uintmax;
 
-#  ifdef __has_builtin
-#    define ckd_has_builtin(x) __has_builtin(x)
-#  else
-#    define ckd_has_builtin(x) 0
-#  endif
+/* two-limb stand-ins for __int128, see below */
+#if !defined(ckd_have_int128) \
+    && (defined(__cplusplus) && (__cplusplus >= 201103L || defined(_MSC_VER)) \
+        || defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L)
+typedef struct ckd_i128
+{
+  unsigned long long lo, hi;
+} ckd_i128;
+typedef struct ckd_u128
+{
+  unsigned long long lo, hi;
+} ckd_u128;
+/* clang-format off */
+#  define ckd_generic_limbs(x, y) \
+    , ckd_i128: x \
+    , ckd_u128: y
+/* clang-format on */
+#else
+#  define ckd_generic_limbs(x, y)
+#endif
+
+#if defined(__GNUC__) || defined(__llvm__)
+#  define ckd_unreachable(x) __builtin_unreachable()
+#elif defined(_MSC_VER)
+#  define ckd_unreachable(x) __assume(0)
+#else
+#  define ckd_unreachable(x) return (x)
+#endif
+
+/*
+ * Our polyfills are written in terms of a lane type L, which must be
+ * at least as wide as the result and operand types. The scalar API
+ * always uses ckd_uintmax lanes. The span API picks narrower lanes so
+ * the compiler is able to vectorize the bit hacks.
+ */
+
+#if defined(__cplusplus) \
+    && (__cplusplus >= 201103L \
+        || defined(_MSC_VER) && __cplusplus >= 199711L \
+            && ckd_has_include(<type_traits>) && ckd_has_include(<limits>))
+#  define ckd_have_templates
+#  include <cstddef>
+#  include <limits>
+#  include <type_traits>
 
 #  if defined(__GNUC__) || defined(__llvm__)
-#    define ckd_unreachable(x) __builtin_unreachable()
+#    define ckd_inline inline __attribute__((__always_inline__, __artificial__))
 #  elif defined(_MSC_VER)
-#    define ckd_unreachable(x) __assume(0)
+#    define ckd_inline __forceinline
 #  else
-#    define ckd_unreachable(x) return (x)
-#  endif
-
-#  if !defined(__STRICT_ANSI__) \
-      && (defined(__GNUC__) && __GNUC__ >= 5 && !defined(__ICC) \
-          || ckd_has_builtin(__builtin_add_overflow) \
-              && ckd_has_builtin(__builtin_sub_overflow) \
-              && ckd_has_builtin(__builtin_mul_overflow))
-#    include <stdbool.h>
-
-#    define ckd_add(res, x, y) ((bool)__builtin_add_overflow((x), (y), (res)))
-#    define ckd_sub(res, x, y) ((bool)__builtin_sub_overflow((x), (y), (res)))
-#    define ckd_mul(res, x, y) ((bool)__builtin_mul_overflow((x), (y), (res)))
-
-#  elif defined(__cplusplus) \
-      && (__cplusplus >= 201103L \
-          || defined(_MSC_VER) && __cplusplus >= 199711L \
-              && ckd_has_include(<type_traits>) && ckd_has_include(<limits>))
-#    include <limits>
-#    include <type_traits>
-
-#    if defined(__GNUC__) || defined(__llvm__)
-#      define ckd_inline \
-        inline __attribute__((__always_inline__, __artificial__))
-#    elif defined(_MSC_VER)
-#      define ckd_inline __forceinline
-#    else
-#      define ckd_inline inline
-#    endif
+#    define ckd_inline inline
+#  endif
 
-#    if defined(_MSC_VER) && defined(_MSVC_LANG) && _MSC_VER >= 1915 \
-            && _MSVC_LANG >= 201402L \
-        || defined(__llvm__) && ckd_has_feature(__cxx_generic_lambdas__) \
-            && ckd_has_feature(__cxx_relaxed_constexpr__) \
-        || defined(__cpp_constexpr) && (__cpp_constexpr >= 201304L)
-#      define ckd_constexpr constexpr
-#    else
-#      define ckd_constexpr
-#    endif
+#  if defined(_MSC_VER) && defined(_MSVC_LANG) && _MSC_VER >= 1915 \
+          && _MSVC_LANG >= 201402L \
+      || defined(__llvm__) && ckd_has_feature(__cxx_generic_lambdas__) \
+          && ckd_has_feature(__cxx_relaxed_constexpr__) \
+      || defined(__cpp_constexpr) && (__cpp_constexpr >= 201304L)
+#    define ckd_constexpr constexpr
+#    define ckd_have_constexpr
+#  else
+#    define ckd_constexpr
+#  endif
+
+// Backends that can't run at compile time, i.e. the builtins, inline
+// assembly and the library, are bypassed for the polyfill when they are.
+#  if defined(ckd_have_constexpr) && defined(__cpp_lib_is_constant_evaluated)
+#    define ckd_have_constant_evaluated
+#    define ckd_is_constant_evaluated() std::is_constant_evaluated()
+#  elif defined(ckd_have_constexpr) \
+      && (ckd_has_builtin(__builtin_is_constant_evaluated) \
+          || defined(__GNUC__) && __GNUC__ >= 9 && !defined(__llvm__))
+#    define ckd_have_constant_evaluated
+#    define ckd_is_constant_evaluated() __builtin_is_constant_evaluated()
+#  else
+#    define ckd_is_constant_evaluated() false
+#  endif
+
+// Each signedness combination of T, U and V has its own formula, which
+// is selected by overloading on ckd_case<N>. That way an instantiation
+// only contains the code for its own case, even in unoptimized builds.
+// Cases 0 through 7 are the bits of ckd_signs. Cases 8 through 10 mean
+// the exact result is known to fit in SL, so only T needs checking; 9
+// and 10 being for unsigned T as wide as L, when the result can't / can
+// be negative. The public functions call these directly, because each
+// level of inlining costs a copy of its arguments at -O0.
+template<int N>
+struct ckd_case : std::integral_constant<int, N>
+{};
 
 template<typename T, typename U, typename V>
-ckd_constexpr ckd_inline bool ckd_add(T* res, U a, V b)
+struct ckd_signs
+    : std::integral_constant<int,
+                             std::is_signed<T>::value << 2
+                                 | std::is_signed<U>::value << 1
+                                 | std::is_signed<V>::value>
 {
   static_assert(std::is_integral<T>::value && std::is_integral<U>::value
                     && std::is_integral<V>::value,
@@ -158,497 +266,5286 @@ ckd_constexpr ckd_inline bool ckd_add(T* res, U a, V b)
   static_assert(!std::is_same<T, char>::value && !std::is_same<U, char>::value
                     && !std::is_same<V, char>::value,
                 "unqualified char type is ambiguous");
-  auto x = static_cast<ckd_uintmax>(a);
-  auto y = static_cast<ckd_uintmax>(b);
-  auto z = x + y;
+};
+
+template<typename L, typename T, bool Negative>
+struct ckd_fits
+    : std::integral_constant<int,
+                             (sizeof(L) > sizeof(T) || std::is_signed<T>::value)
+                                 ? 8
+                                 : (Negative ? 10 : 9)>
+{};
+
+// Sums and differences fit in SL when both operands are narrower, but
+// differences may always be negative.
+template<typename L,
+         typename T,
+         typename U,
+         typename V,
+         bool Negative = std::is_signed<U>::value || std::is_signed<V>::value>
+struct ckd_add_case
+    : std::integral_constant<int,
+                             (sizeof(L) > sizeof(U) && sizeof(L) > sizeof(V))
+                                 ? ckd_fits<L, T, Negative>::value
+                                 : ckd_signs<T, U, V>::value>
+{};
+
+// Products fit when the operand bits add up to no more than T has.
+template<typename L,
+         typename T,
+         typename U,
+         typename V,
+         bool Negative = std::is_signed<U>::value || std::is_signed<V>::value>
+struct ckd_mul_case
+    : std::integral_constant<int,
+                             (sizeof(U) * 8 - std::is_signed<U>::value)
+                                         + (sizeof(V) * 8
+                                            - std::is_signed<V>::value)
+                                     <= (sizeof(T) * 8
+                                         - std::is_signed<T>::value)
+                                 ? ckd_fits<L, T, Negative>::value
+                                 : ckd_signs<T, U, V>::value>
+{};
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<8>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<SL>(x + y);
+  return z != (*res = static_cast<T>(z));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<9>, T* res, L x, L y)
+{
+  auto z = static_cast<L>(x + y);
+  return z != (*res = static_cast<T>(z));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<10>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  return (z != (*res = static_cast<T>(z))) | (static_cast<SL>(z) < 0);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<0>, T* res, L x, L y)
+{
+  // u = u + u
+  auto z = static_cast<L>(x + y);
   *res = static_cast<T>(z);
-  if (sizeof(z) > sizeof(U) && sizeof(z) > sizeof(V)) {
-    if (sizeof(z) > sizeof(T) || std::is_signed<T>::value) {
-      return static_cast<ckd_intmax>(z) != static_cast<T>(z);
-    } else if (!std::is_same<T, ckd_uintmax>::value) {
-      return (z != static_cast<T>(z)
-              || ((std::is_signed<U>::value || std::is_signed<V>::value)
-                  && static_cast<ckd_intmax>(z) < 0));
-    }
-  }
-  bool truncated = false;
-  if (sizeof(T) < sizeof(ckd_intmax)) {
-    truncated = z != static_cast<ckd_uintmax>(static_cast<T>(z));
-  }
-  switch (std::is_signed<T>::value << 2 |  //
-          std::is_signed<U>::value << 1 |  //
-          std::is_signed<V>::value)
-  {
-    case 0:  // u = u + u
-      return truncated | (z < x);
-    case 1:  // u = u + s
-      y ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (static_cast<ckd_intmax>((z ^ x) & (z ^ y)) < 0);
-    case 2:  // u = s + u
-      x ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (static_cast<ckd_intmax>((z ^ x) & (z ^ y)) < 0);
-    case 3:  // u = s + s
-      return truncated
-          | (static_cast<ckd_intmax>(((z | x) & y) | ((z & x) & ~y)) < 0);
-    case 4:  // s = u + u
-      return truncated | (z < x) | (static_cast<ckd_intmax>(z) < 0);
-    case 5:  // s = u + s
-      y ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (x + y < y);
-    case 6:  // s = s + u
-      x ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (x + y < x);
-    case 7:  // s = s + s
-      return truncated | (static_cast<ckd_intmax>((z ^ x) & (z ^ y)) < 0);
-    default:
-      ckd_unreachable(false);
-  }
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res)) | (z < x);
 }
 
-template<typename T, typename U, typename V>
-ckd_constexpr ckd_inline bool ckd_sub(T* res, U a, V b)
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<1>, T* res, L x, L y)
 {
-  static_assert(std::is_integral<T>::value && std::is_integral<U>::value
-                    && std::is_integral<V>::value,
-                "non-integral types not allowed");
-  static_assert(!std::is_same<T, bool>::value && !std::is_same<U, bool>::value
-                    && !std::is_same<V, bool>::value,
-                "checked booleans not supported");
-  static_assert(!std::is_same<T, char>::value && !std::is_same<U, char>::value
-                    && !std::is_same<V, char>::value,
-                "unqualified char type is ambiguous");
-  auto x = static_cast<ckd_uintmax>(a);
-  auto y = static_cast<ckd_uintmax>(b);
-  auto z = x - y;
+  // u = u + s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
   *res = static_cast<T>(z);
-  bool truncated = false;
-  if (sizeof(T) < sizeof(ckd_intmax)) {
-    truncated = z != static_cast<ckd_uintmax>(static_cast<T>(z));
-  }
-  switch (std::is_signed<T>::value << 2 |  //
-          std::is_signed<U>::value << 1 |  //
-          std::is_signed<V>::value)
-  {
-    case 0:  // u = u - u
-      return truncated | (x < y);
-    case 1:  // u = u - s
-      y ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (static_cast<ckd_intmax>((x ^ y) & (z ^ x)) < 0);
-    case 2:  // u = s - u
-      return truncated | (y > x) | (static_cast<ckd_intmax>(x) < 0);
-    case 3:  // u = s - s
-      return truncated
-          | (static_cast<ckd_intmax>(((z & x) & y) | ((z | x) & ~y)) < 0);
-    case 4:  // s = u - u
-      return truncated | ((x < y) ^ (static_cast<ckd_intmax>(z) < 0));
-    case 5:  // s = u - s
-      y ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (x >= y);
-    case 6:  // s = s - u
-      x ^= static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::min)());
-      return truncated | (x < y);
-    case 7:  // s = s - s
-      return truncated | (static_cast<ckd_intmax>((x ^ y) & (z ^ x)) < 0);
-    default:
-      ckd_unreachable(false);
-  }
+  y ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>((z ^ x) & (z ^ y)) < 0);
 }
 
-template<typename T, typename U, typename V>
-ckd_constexpr ckd_inline bool ckd_mul(T* res, U a, V b)
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<2>, T* res, L x, L y)
 {
-  static_assert(std::is_integral<T>::value && std::is_integral<U>::value
-                    && std::is_integral<V>::value,
-                "non-integral types not allowed");
-  static_assert(!std::is_same<T, bool>::value && !std::is_same<U, bool>::value
-                    && !std::is_same<V, bool>::value,
-                "checked booleans not supported");
-  static_assert(!std::is_same<T, char>::value && !std::is_same<U, char>::value
-                    && !std::is_same<V, char>::value,
-                "unqualified char type is ambiguous");
-  auto x = static_cast<ckd_uintmax>(a);
-  auto y = static_cast<ckd_uintmax>(b);
-  if ((sizeof(U) * 8 - std::is_signed<U>::value)
-          + (sizeof(V) * 8 - std::is_signed<V>::value)
-      <= (sizeof(T) * 8 - std::is_signed<T>::value))
-  {
-    if (sizeof(ckd_uintmax) > sizeof(T) || std::is_signed<T>::value) {
-      auto z = static_cast<ckd_intmax>(x * y);
-      return z != (*res = static_cast<T>(z));
-    } else if (!std::is_same<T, ckd_uintmax>::value) {
-      auto z = x * y;
-      *res = static_cast<T>(z);
-      return (z != static_cast<T>(z)
-              || ((std::is_signed<U>::value || std::is_signed<V>::value)
-                  && static_cast<ckd_intmax>(z) < 0));
-    }
-  }
-  switch (std::is_signed<T>::value << 2 |  //
-          std::is_signed<U>::value << 1 |  //
-          std::is_signed<V>::value)
-  {
-    case 0: {  // u = u * u
-      auto z = x * y;
-      bool o = x && z / x != y;
-      *res = static_cast<T>(z);
-      return o | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res));
-    }
-    case 1: {  // u = u * s
-      auto z = x * y;
-      bool o = x && z / x != y;
-      *res = static_cast<T>(z);
-      return (o | ((static_cast<ckd_intmax>(y) < 0) & !!x)
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    case 2: {  // u = s * u
-      auto z = x * y;
-      bool o = x && z / x != y;
-      *res = static_cast<T>(z);
-      return (o | ((static_cast<ckd_intmax>(x) < 0) & !!y)
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    case 3: {  // u = s * s
-      bool o = false;
-      if (static_cast<ckd_intmax>(x & y) < 0) {
-        x = -x;
-        y = -y;
-      } else if (static_cast<ckd_intmax>(x ^ y) < 0) {
-        o = x && y;
-      }
-      auto z = x * y;
-      o |= x && z / x != y;
-      *res = static_cast<T>(z);
-      return o | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res));
-    }
-    case 4: {  // s = u * u
-      auto z = x * y;
-      bool o = x && z / x != y;
-      *res = static_cast<T>(z);
-      return (o | (static_cast<ckd_intmax>(z) < 0)
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    case 5: {  // s = u * s
-      auto t = -y;
-      t = static_cast<ckd_intmax>(t) < 0 ? y : t;
-      auto p = t * x;
-      bool o = t && p / t != x;
-      bool n = static_cast<ckd_intmax>(y) < 0;
-      auto z = n ? -p : p;
-      *res = static_cast<T>(z);
-      auto m =
-          static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::max)());
-      return (o | (p > m + n)
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    case 6: {  // s = s * u
-      auto t = -x;
-      t = static_cast<ckd_intmax>(t) < 0 ? x : t;
-      auto p = t * y;
-      bool o = t && p / t != y;
-      bool n = static_cast<ckd_intmax>(x) < 0;
-      auto z = n ? -p : p;
-      *res = static_cast<T>(z);
-      auto m =
-          static_cast<ckd_uintmax>((std::numeric_limits<ckd_intmax>::max)());
-      return (o | (p > m + n)
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    case 7: {  // s = s * s
-      auto z = x * y;
-      *res = static_cast<T>(z);
-      return ((((static_cast<ckd_intmax>(y) < 0)
-                && (static_cast<ckd_intmax>(x)
-                    == (std::numeric_limits<ckd_intmax>::min)()))
-               || (y
-                   && ((static_cast<ckd_intmax>(z) / static_cast<ckd_intmax>(y))
-                       != static_cast<ckd_intmax>(x))))
-              | (sizeof(T) < sizeof(z) && z != static_cast<ckd_uintmax>(*res)));
-    }
-    default:
-      ckd_unreachable(false);
-  }
+  // u = s + u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  x ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>((z ^ x) & (z ^ y)) < 0);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<3>, T* res, L x, L y)
+{
+  // u = s + s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>(((z | x) & y) | ((z & x) & ~y)) < 0);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<4>, T* res, L x, L y)
+{
+  // s = u + u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (z < x) | (static_cast<SL>(z) < 0);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<5>, T* res, L x, L y)
+{
+  // s = u + s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  y ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<L>(x + y) < y);
 }
 
-#  elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<6>, T* res, L x, L y)
+{
+  // s = s + u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  x ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<L>(x + y) < x);
+}
 
-#    include <stdbool.h>
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_add(ckd_case<7>, T* res, L x, L y)
+{
+  // s = s + s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x + y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>((z ^ x) & (z ^ y)) < 0);
+}
 
-#    define ckd_add(res, a, b) ckd_expr(add, (res), (a), (b))
-#    define ckd_sub(res, a, b) ckd_expr(sub, (res), (a), (b))
-#    define ckd_mul(res, a, b) ckd_expr(mul, (res), (a), (b))
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_add(T* res, U a, V b)
+{
+  return ckd_lane_add(ckd_case<ckd_add_case<L, T, U, V>::value>(),
+                      res,
+                      static_cast<L>(a),
+                      static_cast<L>(b));
+}
 
-#    if defined(__GNUC__) || defined(__llvm__)
-#      define ckd_inline \
-        extern __inline \
-            __attribute__((__gnu_inline__, __always_inline__, __artificial__))
-#    elif defined(_MSC_VER)
-#      define ckd_inline static __forceinline
-#    else
-#      define ckd_inline static inline
-#    endif
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<8>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<SL>(x - y);
+  return z != (*res = static_cast<T>(z));
+}
 
-#    ifdef ckd_have_int128
-/* clang-format off */
-#      define ckd_generic_int128(x, y) \
-        , signed __int128: x \
-        , unsigned __int128: y
-/* clang-format on */
-#    else
-#      define ckd_generic_int128(x, y)
-#    endif
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<9>, T* res, L x, L y)
+{
+  auto z = static_cast<L>(x - y);
+  return z != (*res = static_cast<T>(z));
+}
 
-#    define ckd_sign(T) ((T)1 << (sizeof(T) * 8 - 1))
-
-#    define ckd_is_signed(x) \
-      _Generic(x, \
-          signed char: 1, \
-          unsigned char: 0, \
-          signed short: 1, \
-          unsigned short: 0, \
-          signed int: 1, \
-          unsigned int: 0, \
-          signed long: 1, \
-          unsigned long: 0, \
-          signed long long: 1, \
-          unsigned long long: 0 ckd_generic_int128(1, 0))
-
-#    define ckd_expr(op, res, a, b) \
-      (_Generic(*res, \
-           signed char: ckd_##op##_schar, \
-           unsigned char: ckd_##op##_uchar, \
-           signed short: ckd_##op##_sshort, \
-           unsigned short: ckd_##op##_ushort, \
-           signed int: ckd_##op##_sint, \
-           unsigned int: ckd_##op##_uint, \
-           signed long: ckd_##op##_slong, \
-           unsigned long: ckd_##op##_ulong, \
-           signed long long: ckd_##op##_slonger, \
-           unsigned long long: ckd_##op##_ulonger ckd_generic_int128( \
-               ckd_##op##_sint128, ckd_##op##_uint128))( \
-          res, \
-          (ckd_uintmax)(a), \
-          (ckd_uintmax)(b), \
-          (ckd_is_signed(a) << 1) | ckd_is_signed(b)))
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<10>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  return (z != (*res = static_cast<T>(z))) | (static_cast<SL>(z) < 0);
+}
 
-#    define ckd_declare_add(S, T) \
-      ckd_inline bool S( \
-          void* res, ckd_uintmax x, ckd_uintmax y, unsigned char ab_signed) \
-      { \
-        ckd_uintmax z = x + y; \
-        *(T*)res = (T)z; \
-        bool truncated = false; \
-        if (sizeof(T) < sizeof(ckd_intmax)) { \
-          truncated = z != (ckd_uintmax)(T)z; \
-        } \
-        switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
-          case 0: /* u = u + u */ \
-            return (bool)(truncated | (z < x)); \
-          case 1: /* u = u + s */ \
-            y ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | ((ckd_intmax)((z ^ x) & (z ^ y)) < 0)); \
-          case 2: /* u = s + u */ \
-            x ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | ((ckd_intmax)((z ^ x) & (z ^ y)) < 0)); \
-          case 3: /* u = s + s */ \
-            return ( \
-                bool)(truncated \
-                      | ((ckd_intmax)(((z | x) & y) | ((z & x) & ~y)) < 0)); \
-          case 4: /* s = u + u */ \
-            return (bool)(truncated | (z < x) | ((ckd_intmax)z < 0)); \
-          case 5: /* s = u + s */ \
-            y ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | (x + y < y)); \
-          case 6: /* s = s + u */ \
-            x ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | (x + y < x)); \
-          case 7: /* s = s + s */ \
-            return (bool)(truncated | ((ckd_intmax)((z ^ x) & (z ^ y)) < 0)); \
-          default: \
-            ckd_unreachable(0); \
-        } \
-      }
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<0>, T* res, L x, L y)
+{
+  // u = u - u
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res)) | (x < y);
+}
 
-ckd_declare_add(ckd_add_schar, signed char)
-ckd_declare_add(ckd_add_uchar, unsigned char)
-ckd_declare_add(ckd_add_sshort, signed short)
-ckd_declare_add(ckd_add_ushort, unsigned short)
-ckd_declare_add(ckd_add_sint, signed int)
-ckd_declare_add(ckd_add_uint, unsigned int)
-ckd_declare_add(ckd_add_slong, signed long)
-ckd_declare_add(ckd_add_ulong, unsigned long)
-ckd_declare_add(ckd_add_slonger, signed long long)
-ckd_declare_add(ckd_add_ulonger, unsigned long long)
-#    ifdef ckd_have_int128
-ckd_declare_add(ckd_add_sint128, signed __int128)
-ckd_declare_add(ckd_add_uint128, unsigned __int128)
-#    endif
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<1>, T* res, L x, L y)
+{
+  // u = u - s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  y ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>((x ^ y) & (z ^ x)) < 0);
+}
 
-#    define ckd_declare_sub(S, T) \
-      ckd_inline bool S( \
-          void* res, ckd_uintmax x, ckd_uintmax y, unsigned char ab_signed) \
-      { \
-        ckd_uintmax z = x - y; \
-        *(T*)res = (T)z; \
-        bool truncated = false; \
-        if (sizeof(T) < sizeof(ckd_intmax)) { \
-          truncated = z != (ckd_uintmax)(T)z; \
-        } \
-        switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
-          case 0: /* u = u - u */ \
-            return (bool)(truncated | (x < y)); \
-          case 1: /* u = u - s */ \
-            y ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | ((ckd_intmax)((x ^ y) & (z ^ x)) < 0)); \
-          case 2: /* u = s - u */ \
-            return (bool)(truncated | (y > x) | ((ckd_intmax)x < 0)); \
-          case 3: /* u = s - s */ \
-            return ( \
-                bool)(truncated \
-                      | ((ckd_intmax)(((z & x) & y) | ((z | x) & ~y)) < 0)); \
-          case 4: /* s = u - u */ \
-            return (bool)(truncated | ((x < y) ^ ((ckd_intmax)z < 0))); \
-          case 5: /* s = u - s */ \
-            y ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | (x >= y)); \
-          case 6: /* s = s - u */ \
-            x ^= ckd_sign(ckd_uintmax); \
-            return (bool)(truncated | (x < y)); \
-          case 7: /* s = s - s */ \
-            return (bool)(truncated | ((ckd_intmax)((x ^ y) & (z ^ x)) < 0)); \
-          default: \
-            ckd_unreachable(0); \
-        } \
-      }
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<2>, T* res, L x, L y)
+{
+  // u = s - u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (y > x) | (static_cast<SL>(x) < 0);
+}
 
-ckd_declare_sub(ckd_sub_schar, signed char)
-ckd_declare_sub(ckd_sub_uchar, unsigned char)
-ckd_declare_sub(ckd_sub_sshort, signed short)
-ckd_declare_sub(ckd_sub_ushort, unsigned short)
-ckd_declare_sub(ckd_sub_sint, signed int)
-ckd_declare_sub(ckd_sub_uint, unsigned int)
-ckd_declare_sub(ckd_sub_slong, signed long)
-ckd_declare_sub(ckd_sub_ulong, unsigned long)
-ckd_declare_sub(ckd_sub_slonger, signed long long)
-ckd_declare_sub(ckd_sub_ulonger, unsigned long long)
-#    ifdef ckd_have_int128
-ckd_declare_sub(ckd_sub_sint128, signed __int128)
-ckd_declare_sub(ckd_sub_uint128, unsigned __int128)
-#    endif
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<3>, T* res, L x, L y)
+{
+  // u = s - s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>(((z & x) & y) | ((z | x) & ~y)) < 0);
+}
 
-#    define ckd_declare_mul(S, T) \
-      ckd_inline bool S( \
-          void* res, ckd_uintmax x, ckd_uintmax y, unsigned char ab_signed) \
-      { \
-        switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
-          case 0: { /* u = u * u */ \
-            ckd_uintmax z = x * y; \
-            bool o = x && z / x != y; \
-            *(T*)res = (T)z; \
-            return (bool)(o \
-                          | (sizeof(T) < sizeof(z) \
-                             && z != (ckd_uintmax)(*(T*)res))); \
-          } \
-          case 1: { /* u = u * s */ \
-            ckd_uintmax z = x * y; \
-            bool o = x && z / x != y; \
-            *(T*)res = (T)z; \
-            return (bool)(( \
-                o | (((ckd_intmax)y < 0) & !!x) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          case 2: { /* u = s * u */ \
-            ckd_uintmax z = x * y; \
-            bool o = x && z / x != y; \
-            *(T*)res = (T)z; \
-            return (bool)(( \
-                o | (((ckd_intmax)x < 0) & !!y) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          case 3: { /* u = s * s */ \
-            bool o = false; \
-            if ((ckd_intmax)(x & y) < 0) { \
-              x = -x; \
-              y = -y; \
-            } else if ((ckd_intmax)(x ^ y) < 0) { \
-              o = x && y; \
-            } \
-            ckd_uintmax z = x * y; \
-            o |= x && z / x != y; \
-            *(T*)res = (T)z; \
-            return (bool)(o \
-                          | (sizeof(T) < sizeof(z) \
-                             && z != (ckd_uintmax)(*(T*)res))); \
-          } \
-          case 4: { /* s = u * u */ \
-            ckd_uintmax z = x * y; \
-            bool o = x && z / x != y; \
-            *(T*)res = (T)z; \
-            return (bool)(( \
-                o | ((ckd_intmax)(z) < 0) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          case 5: { /* s = u * s */ \
-            ckd_uintmax t = -y; \
-            t = (ckd_intmax)(t) < 0 ? y : t; \
-            ckd_uintmax p = t * x; \
-            bool o = t && p / t != x; \
-            bool n = (ckd_intmax)y < 0; \
-            ckd_uintmax z = n ? -p : p; \
-            *(T*)res = (T)z; \
-            ckd_uintmax m = ckd_sign(ckd_uintmax) - 1; \
-            return (bool)(( \
-                o | (p > m + (ckd_uintmax)n) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          case 6: { /* s = s * u */ \
-            ckd_uintmax t = -x; \
-            t = (ckd_intmax)(t) < 0 ? x : t; \
-            ckd_uintmax p = t * y; \
-            bool o = t && p / t != y; \
-            bool n = (ckd_intmax)x < 0; \
-            ckd_uintmax z = n ? -p : p; \
-            *(T*)res = (T)z; \
-            ckd_uintmax m = ckd_sign(ckd_uintmax) - 1; \
-            return (bool)(( \
-                o | (p > m + (ckd_uintmax)n) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          case 7: { /* s = s * s */ \
-            ckd_uintmax z = x * y; \
-            *(T*)res = (T)z; \
-            return (bool)(( \
-                ((((ckd_intmax)y < 0) && (x == ckd_sign(ckd_uintmax))) \
-                 || (y && (((ckd_intmax)z / (ckd_intmax)y) != (ckd_intmax)x))) \
-                | (sizeof(T) < sizeof(z) && z != (ckd_uintmax)(*(T*)res)))); \
-          } \
-          default: \
-            ckd_unreachable(0); \
-        } \
-      }
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<4>, T* res, L x, L y)
+{
+  // s = u - u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | ((x < y) ^ (static_cast<SL>(z) < 0));
+}
 
-ckd_declare_mul(ckd_mul_schar, signed char)
-ckd_declare_mul(ckd_mul_uchar, unsigned char)
-ckd_declare_mul(ckd_mul_sshort, signed short)
-ckd_declare_mul(ckd_mul_ushort, unsigned short)
-ckd_declare_mul(ckd_mul_sint, signed int)
-ckd_declare_mul(ckd_mul_uint, unsigned int)
-ckd_declare_mul(ckd_mul_slong, signed long)
-ckd_declare_mul(ckd_mul_ulong, unsigned long)
-ckd_declare_mul(ckd_mul_slonger, signed long long)
-ckd_declare_mul(ckd_mul_ulonger, unsigned long long)
-#    ifdef ckd_have_int128
-ckd_declare_mul(ckd_mul_sint128, signed __int128)
-ckd_declare_mul(ckd_mul_uint128, unsigned __int128)
-#    endif
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<5>, T* res, L x, L y)
+{
+  // s = u - s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  y ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res)) | (x >= y);
+}
 
-#  else
-#    pragma message( \
-        "checked integer arithmetic unsupported in this environment")
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<6>, T* res, L x, L y)
+{
+  // s = s - u
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  x ^= static_cast<L>((std::numeric_limits<SL>::min)());
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res)) | (x < y);
+}
 
-#    define ckd_add(res, x, y) (*(res) = (x) + (y), 0)
-#    define ckd_sub(res, x, y) (*(res) = (x) - (y), 0)
-#    define ckd_mul(res, x, y) (*(res) = (x) * (y), 0)
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_sub(ckd_case<7>, T* res, L x, L y)
+{
+  // s = s - s
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x - y);
+  *res = static_cast<T>(z);
+  return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res))
+      | (static_cast<SL>((x ^ y) & (z ^ x)) < 0);
+}
+
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_sub(T* res, U a, V b)
+{
+  return ckd_lane_sub(ckd_case<ckd_add_case<L, T, U, V, true>::value>(),
+                      res,
+                      static_cast<L>(a),
+                      static_cast<L>(b));
+}
+
+// Dividing L is a libcall when it's wider than a machine word, e.g. long
+// long on 32-bit systems, or __int128.
+template<typename L>
+struct ckd_div_libcall
+    : std::integral_constant<bool, (sizeof(L) > sizeof(void*))>
+{};
+
+// Multiplies x and y, returning true if the product doesn't fit in L.
+// When L fits in a register, compilers turn this division into a mul
+// and a check of the overflow flag.
+template<typename L>
+ckd_constexpr ckd_inline bool ckd_umulo(std::false_type, L* z, L x, L y)
+{
+  *z = static_cast<L>(x * y);
+  return x && *z / x != y;
+}
+
+// Otherwise most operands fit in half a word, so that's checked first.
+// If they don't, at most one cross term may be nonzero for the product
+// to fit, which avoids the division.
+template<typename L>
+ckd_constexpr ckd_inline bool ckd_umulo(std::true_type, L* z, L x, L y)
+{
+  const int h = static_cast<int>(sizeof(L) * 4);
+  const L m = static_cast<L>((static_cast<L>(1) << h) - 1);
+  L xh = x >> h;
+  L yh = y >> h;
+  if (!(xh | yh)) {
+    *z = static_cast<L>(x * y);
+    return false;
+  }
+  L c = static_cast<L>(xh * (y & m) + yh * (x & m));
+  L p = static_cast<L>(c << h);
+  *z = static_cast<L>(p + (x & m) * (y & m));
+  return (!!xh & !!yh) | !!(c >> h) | (*z < p);
+}
+
+template<typename L>
+ckd_constexpr ckd_inline bool ckd_umulo(L* z, L x, L y)
+{
+  return ckd_umulo(ckd_div_libcall<L>(), z, x, y);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<8>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<SL>(x * y);
+  return z != (*res = static_cast<T>(z));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<9>, T* res, L x, L y)
+{
+  auto z = static_cast<L>(x * y);
+  return z != (*res = static_cast<T>(z));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<10>, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x * y);
+  return (z != (*res = static_cast<T>(z))) | (static_cast<SL>(z) < 0);
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<0>, T* res, L x, L y)
+{
+  // u = u * u
+  L z = 0;
+  bool o = ckd_umulo(&z, x, y);
+  *res = static_cast<T>(z);
+  return o | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<1>, T* res, L x, L y)
+{
+  // u = u * s
+  typedef typename std::make_signed<L>::type SL;
+  L z = 0;
+  bool o = ckd_umulo(&z, x, y);
+  *res = static_cast<T>(z);
+  return o | ((static_cast<SL>(y) < 0) & !!x)
+      | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<2>, T* res, L x, L y)
+{
+  // u = s * u
+  typedef typename std::make_signed<L>::type SL;
+  L z = 0;
+  bool o = ckd_umulo(&z, x, y);
+  *res = static_cast<T>(z);
+  return o | ((static_cast<SL>(x) < 0) & !!y)
+      | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<3>, T* res, L x, L y)
+{
+  // u = s * s
+  typedef typename std::make_signed<L>::type SL;
+  bool o = false;
+  if (static_cast<SL>(x & y) < 0) {
+    x = -x;
+    y = -y;
+  } else if (static_cast<SL>(x ^ y) < 0) {
+    o = x && y;
+  }
+  L z = 0;
+  o |= ckd_umulo(&z, x, y);
+  *res = static_cast<T>(z);
+  return o | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<4>, T* res, L x, L y)
+{
+  // s = u * u
+  typedef typename std::make_signed<L>::type SL;
+  L z = 0;
+  bool o = ckd_umulo(&z, x, y);
+  *res = static_cast<T>(z);
+  return o | (static_cast<SL>(z) < 0)
+      | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<5>, T* res, L x, L y)
+{
+  // s = u * s
+  typedef typename std::make_signed<L>::type SL;
+  auto t = -y;
+  t = static_cast<SL>(t) < 0 ? y : t;
+  L p = 0;
+  bool o = ckd_umulo(&p, t, x);
+  bool n = static_cast<SL>(y) < 0;
+  auto z = n ? -p : p;
+  *res = static_cast<T>(z);
+  auto m = static_cast<L>((std::numeric_limits<SL>::max)());
+  return o | (p > m + n) | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<6>, T* res, L x, L y)
+{
+  // s = s * u
+  typedef typename std::make_signed<L>::type SL;
+  auto t = -x;
+  t = static_cast<SL>(t) < 0 ? x : t;
+  L p = 0;
+  bool o = ckd_umulo(&p, t, y);
+  bool n = static_cast<SL>(x) < 0;
+  auto z = n ? -p : p;
+  *res = static_cast<T>(z);
+  auto m = static_cast<L>((std::numeric_limits<SL>::max)());
+  return o | (p > m + n) | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_smulo(std::false_type, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto z = static_cast<L>(x * y);
+  *res = static_cast<T>(z);
+  return (((static_cast<SL>(y) < 0)
+           && (static_cast<SL>(x) == (std::numeric_limits<SL>::min)()))
+          || (y
+              && ((static_cast<SL>(z) / static_cast<SL>(y))
+                  != static_cast<SL>(x))))
+      | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_smulo(std::true_type, T* res, L x, L y)
+{
+  typedef typename std::make_signed<L>::type SL;
+  const L h = static_cast<L>(
+      static_cast<L>((std::numeric_limits<SL>::min)()) >> (sizeof(L) * 4));
+  if (!((static_cast<L>(x + h) | static_cast<L>(y + h)) >> (sizeof(L) * 4))) {
+    auto z = static_cast<L>(x * y);
+    *res = static_cast<T>(z);
+    return (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+  }
+  auto t = -x;
+  t = static_cast<SL>(t) < 0 ? x : t;
+  auto u = -y;
+  u = static_cast<SL>(u) < 0 ? y : u;
+  L p = 0;
+  bool o = ckd_umulo(&p, t, u);
+  bool n = static_cast<SL>(x ^ y) < 0;
+  auto z = n ? -p : p;
+  *res = static_cast<T>(z);
+  auto m = static_cast<L>((std::numeric_limits<SL>::max)());
+  return o | (p > m + n) | (sizeof(T) < sizeof(L) && z != static_cast<L>(*res));
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_lane_mul(ckd_case<7>, T* res, L x, L y)
+{
+  // s = s * s
+  return ckd_smulo(ckd_div_libcall<L>(), res, x, y);
+}
+
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_mul(T* res, U a, V b)
+{
+  return ckd_lane_mul(ckd_case<ckd_mul_case<L, T, U, V>::value>(),
+                      res,
+                      static_cast<L>(a),
+                      static_cast<L>(b));
+}
+
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define ckd_have_generic
+#  include <stdbool.h>
+#  include <stddef.h>
+
+/**
+ * JTCKDINT_OPTION_EXTRAS
+ *   = 0: C code only gets the scalar functions and what's built on them
+ *   = 1: C code also gets the span, reduction, muladd and saturating ones
+ *
+ * Which C has to declare as a function for each type and lane width,
+ * so they're left out unless asked for, and other translation units
+ * compile about as fast as they would with the scalar functions alone.
+ * C++ declares them as templates, which cost nothing until they're used,
+ * so it always has them.
+ */
+#  if defined(JTCKDINT_OPTION_EXTRAS) && JTCKDINT_OPTION_EXTRAS == 1
+#    define ckd_have_extras
+#  endif
+
+/* with the builtins, only the extras need the polyfill's functions */
+#  if defined(ckd_have_extras) || defined(__STRICT_ANSI__) \
+      || !(defined(__GNUC__) && __GNUC__ >= 5 && !defined(__ICC) \
+           || ckd_has_builtin(__builtin_add_overflow) \
+               && ckd_has_builtin(__builtin_sub_overflow) \
+               && ckd_has_builtin(__builtin_mul_overflow))
+#    define ckd_have_polyfill
+#  endif
+
+#  if defined(__GNUC__) || defined(__llvm__)
+#    define ckd_inline \
+      extern __inline \
+          __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+#  elif defined(_MSC_VER)
+#    define ckd_inline static __forceinline
+#  else
+#    define ckd_inline static inline
+#  endif
+
+#  ifdef ckd_have_int128
+/* clang-format off */
+#    define ckd_generic_int128(x, y) \
+      , signed __int128: x \
+      , unsigned __int128: y
+/* clang-format on */
+#  else
+#    define ckd_generic_int128(x, y)
+#  endif
+
+typedef signed long long ckd_int64;
+typedef unsigned long long ckd_uint64;
+
+#  define ckd_sign(T) ((T)1 << (sizeof(T) * 8 - 1))
+
+#  define ckd_is_signed(x) \
+    _Generic(x, \
+        signed char: 1, \
+        unsigned char: 0, \
+        signed short: 1, \
+        unsigned short: 0, \
+        signed int: 1, \
+        unsigned int: 0, \
+        signed long: 1, \
+        unsigned long: 0, \
+        signed long long: 1, \
+        unsigned long long: 0 ckd_generic_int128(1, 0) \
+            ckd_generic_limbs(1, 0))
+
+/* expands X(S, T, ...) for every standard integer type T named S */
+#  define ckd_each_int(X, ...) \
+    X(schar, signed char, __VA_ARGS__) \
+    X(uchar, unsigned char, __VA_ARGS__) \
+    X(sshort, signed short, __VA_ARGS__) \
+    X(ushort, unsigned short, __VA_ARGS__) \
+    X(sint, signed int, __VA_ARGS__) \
+    X(uint, unsigned int, __VA_ARGS__) \
+    X(slong, signed long, __VA_ARGS__) \
+    X(ulong, unsigned long, __VA_ARGS__) \
+    X(slonger, signed long long, __VA_ARGS__) \
+    X(ulonger, unsigned long long, __VA_ARGS__)
+
+#  ifdef ckd_have_int128
+#    define ckd_each_int128(X, ...) \
+      X(sint128, signed __int128, __VA_ARGS__) \
+      X(uint128, unsigned __int128, __VA_ARGS__)
+#  endif
+
+#  define ckd_declare_add(S, T, P, L, SL) \
+    ckd_inline bool ckd_##P##_##S(void* res, \
+                                  L x, \
+                                  L y, \
+                                  unsigned char ab_signed) \
+    { \
+      L z = x + y; \
+      *(T*)res = (T)z; \
+      bool truncated = false; \
+      if (sizeof(T) < sizeof(SL)) { \
+        truncated = z != (L)(T)z; \
+      } \
+      switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
+        case 0: /* u = u + u */ \
+          return (bool)(truncated | (z < x)); \
+        case 1: /* u = u + s */ \
+          y ^= ckd_sign(L); \
+          return (bool)(truncated | ((SL)((z ^ x) & (z ^ y)) < 0)); \
+        case 2: /* u = s + u */ \
+          x ^= ckd_sign(L); \
+          return (bool)(truncated | ((SL)((z ^ x) & (z ^ y)) < 0)); \
+        case 3: /* u = s + s */ \
+          return ( \
+              bool)(truncated \
+                    | ((SL)(((z | x) & y) | ((z & x) & ~y)) < 0)); \
+        case 4: /* s = u + u */ \
+          return (bool)(truncated | (z < x) | ((SL)z < 0)); \
+        case 5: /* s = u + s */ \
+          y ^= ckd_sign(L); \
+          return (bool)(truncated | (x + y < y)); \
+        case 6: /* s = s + u */ \
+          x ^= ckd_sign(L); \
+          return (bool)(truncated | (x + y < x)); \
+        case 7: /* s = s + s */ \
+          return (bool)(truncated | ((SL)((z ^ x) & (z ^ y)) < 0)); \
+        default: \
+          ckd_unreachable(0); \
+      } \
+    }
+
+#  ifdef ckd_have_polyfill
+ckd_each_int(ckd_declare_add, add, ckd_uintmax, ckd_intmax)
+#    ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_add, add, ckd_uintmax, ckd_intmax)
+#    endif
+#  endif
+#  if defined(ckd_have_int128) && defined(ckd_have_extras)
+ckd_each_int(ckd_declare_add, add64, ckd_uint64, ckd_int64)
+#  endif
+
+#  define ckd_declare_sub(S, T, P, L, SL) \
+    ckd_inline bool ckd_##P##_##S(void* res, \
+                                  L x, \
+                                  L y, \
+                                  unsigned char ab_signed) \
+    { \
+      L z = x - y; \
+      *(T*)res = (T)z; \
+      bool truncated = false; \
+      if (sizeof(T) < sizeof(SL)) { \
+        truncated = z != (L)(T)z; \
+      } \
+      switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
+        case 0: /* u = u - u */ \
+          return (bool)(truncated | (x < y)); \
+        case 1: /* u = u - s */ \
+          y ^= ckd_sign(L); \
+          return (bool)(truncated | ((SL)((x ^ y) & (z ^ x)) < 0)); \
+        case 2: /* u = s - u */ \
+          return (bool)(truncated | (y > x) | ((SL)x < 0)); \
+        case 3: /* u = s - s */ \
+          return ( \
+              bool)(truncated \
+                    | ((SL)(((z & x) & y) | ((z | x) & ~y)) < 0)); \
+        case 4: /* s = u - u */ \
+          return (bool)(truncated | ((x < y) ^ ((SL)z < 0))); \
+        case 5: /* s = u - s */ \
+          y ^= ckd_sign(L); \
+          return (bool)(truncated | (x >= y)); \
+        case 6: /* s = s - u */ \
+          x ^= ckd_sign(L); \
+          return (bool)(truncated | (x < y)); \
+        case 7: /* s = s - s */ \
+          return (bool)(truncated | ((SL)((x ^ y) & (z ^ x)) < 0)); \
+        default: \
+          ckd_unreachable(0); \
+      } \
+    }
+
+#  ifdef ckd_have_polyfill
+ckd_each_int(ckd_declare_sub, sub, ckd_uintmax, ckd_intmax)
+#    ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_sub, sub, ckd_uintmax, ckd_intmax)
+#    endif
+#  endif
+#  if defined(ckd_have_int128) && defined(ckd_have_extras)
+ckd_each_int(ckd_declare_sub, sub64, ckd_uint64, ckd_int64)
+#  endif
+
+/* dividing L is a libcall when it's wider than a machine word, e.g. long
+   long on 32-bit systems, or __int128. */
+#  define ckd_div_libcall(L) (sizeof(L) > sizeof(void*))
+
+/* multiplies x and y, returning true if the product doesn't fit in L.
+   when L fits in a register, compilers turn the division into a mul and
+   a check of the overflow flag. otherwise most operands fit in half a
+   word, so we check that first, and then at most one cross term can be
+   nonzero if the product is to fit, which avoids the division. */
+#  define ckd_declare_umulo(S, L) \
+    ckd_inline bool S(L* z, L x, L y) \
+    { \
+      if (!ckd_div_libcall(L)) { \
+        *z = x * y; \
+        return x && *z / x != y; \
+      } \
+      L m = ((L)1 << (sizeof(L) * 4)) - 1; \
+      L xh = x >> (sizeof(L) * 4); \
+      L yh = y >> (sizeof(L) * 4); \
+      if (!(xh | yh)) { \
+        *z = x * y; \
+        return false; \
+      } \
+      L c = xh * (y & m) + yh * (x & m); \
+      L p = c << (sizeof(L) * 4); \
+      *z = p + (x & m) * (y & m); \
+      return (bool)((!!xh & !!yh) | !!(c >> (sizeof(L) * 4)) | (*z < p)); \
+    }
+
+ckd_declare_umulo(ckd_umulo_max, ckd_uintmax)
+#  ifdef ckd_have_int128
+ckd_declare_umulo(ckd_umulo64, ckd_uint64)
+#    define ckd_umulo(z, x, y) \
+      _Generic(*(z), ckd_uint64: ckd_umulo64, default: ckd_umulo_max)(z, x, y)
+#  else
+#    define ckd_umulo ckd_umulo_max
+#  endif
+
+#  define ckd_declare_mul(S, T, P, L, SL) \
+    ckd_inline bool ckd_##P##_##S(void* res, \
+                                  L x, \
+                                  L y, \
+                                  unsigned char ab_signed) \
+    { \
+      switch (ckd_is_signed((T)0) << 2 | ab_signed) { \
+        case 0: { /* u = u * u */ \
+          L z; \
+          bool o = ckd_umulo(&z, x, y); \
+          *(T*)res = (T)z; \
+          return (bool)(o \
+                        | (sizeof(T) < sizeof(z) \
+                           && z != (L)(*(T*)res))); \
+        } \
+        case 1: { /* u = u * s */ \
+          L z; \
+          bool o = ckd_umulo(&z, x, y); \
+          *(T*)res = (T)z; \
+          return (bool)(( \
+              o | (((SL)y < 0) & !!x) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        case 2: { /* u = s * u */ \
+          L z; \
+          bool o = ckd_umulo(&z, x, y); \
+          *(T*)res = (T)z; \
+          return (bool)(( \
+              o | (((SL)x < 0) & !!y) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        case 3: { /* u = s * s */ \
+          unsigned char o = 0; \
+          if ((SL)(x & y) < 0) { \
+            x = -x; \
+            y = -y; \
+          } else if ((SL)(x ^ y) < 0) { \
+            o = x && y; \
+          } \
+          L z; \
+          o |= ckd_umulo(&z, x, y); \
+          *(T*)res = (T)z; \
+          return (bool)(o \
+                        | (sizeof(T) < sizeof(z) \
+                           && z != (L)(*(T*)res))); \
+        } \
+        case 4: { /* s = u * u */ \
+          L z; \
+          bool o = ckd_umulo(&z, x, y); \
+          *(T*)res = (T)z; \
+          return (bool)(( \
+              o | ((SL)(z) < 0) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        case 5: { /* s = u * s */ \
+          L t = -y; \
+          t = (SL)(t) < 0 ? y : t; \
+          L p; \
+          bool o = ckd_umulo(&p, t, x); \
+          bool n = (SL)y < 0; \
+          L z = n ? -p : p; \
+          *(T*)res = (T)z; \
+          L m = ckd_sign(L) - 1; \
+          return (bool)(( \
+              o | (p > m + (L)n) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        case 6: { /* s = s * u */ \
+          L t = -x; \
+          t = (SL)(t) < 0 ? x : t; \
+          L p; \
+          bool o = ckd_umulo(&p, t, y); \
+          bool n = (SL)x < 0; \
+          L z = n ? -p : p; \
+          *(T*)res = (T)z; \
+          L m = ckd_sign(L) - 1; \
+          return (bool)(( \
+              o | (p > m + (L)n) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        case 7: { /* s = s * s */ \
+          if (!ckd_div_libcall(L)) { \
+            L z = x * y; \
+            *(T*)res = (T)z; \
+            return (bool)(( \
+                ((((SL)y < 0) && (x == ckd_sign(L))) \
+                 || (y && (((SL)z / (SL)y) != (SL)x))) \
+                | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+          } \
+          L h = ckd_sign(L) >> (sizeof(L) * 4); \
+          if (!(((x + h) | (y + h)) >> (sizeof(L) * 4))) { \
+            L z = x * y; \
+            *(T*)res = (T)z; \
+            return (bool)(sizeof(T) < sizeof(z) && z != (L)(*(T*)res)); \
+          } \
+          L t = -x; \
+          L u = -y; \
+          t = (SL)(t) < 0 ? x : t; \
+          u = (SL)(u) < 0 ? y : u; \
+          L p; \
+          bool o = ckd_umulo(&p, t, u); \
+          bool n = (SL)(x ^ y) < 0; \
+          L z = n ? -p : p; \
+          *(T*)res = (T)z; \
+          L m = ckd_sign(L) - 1; \
+          return (bool)(( \
+              o | (p > m + (L)n) \
+              | (sizeof(T) < sizeof(z) && z != (L)(*(T*)res)))); \
+        } \
+        default: \
+          ckd_unreachable(0); \
+      } \
+    }
+
+#  ifdef ckd_have_polyfill
+ckd_each_int(ckd_declare_mul, mul, ckd_uintmax, ckd_intmax)
+#    ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_mul, mul, ckd_uintmax, ckd_intmax)
+#    endif
+#  endif
+#  if defined(ckd_have_int128) && defined(ckd_have_extras)
+ckd_each_int(ckd_declare_mul, mul64, ckd_uint64, ckd_int64)
+#  endif
+
+#endif
+
+/*
+ * 128-bit integers. When the compiler has __int128 these are just that.
+ * Otherwise they're a pair of 64-bit limbs, which ckd_add, ckd_sub and
+ * ckd_mul accept for any operand or result. The limbs are checked by
+ * computing the exact result lo + hi * 2**64 + top * 2**128 with carry
+ * chains, then seeing if it fits. Products multiply the magnitudes so a
+ * 128-bit multiply only needs three 64-bit ones, and no division. GNU
+ * compilers still let us widen those with __extension__ in strict mode.
+ */
+
+#if defined(ckd_have_int128)
+
+typedef signed __int128 ckd_i128;
+typedef unsigned __int128 ckd_u128;
+
+#  ifdef __cplusplus
+
+inline ckd_i128 ckd_i128_make(long long hi, unsigned long long lo)
+{
+  return static_cast<ckd_i128>(
+      static_cast<ckd_u128>(static_cast<unsigned long long>(hi)) << 64 | lo);
+}
+
+inline unsigned long long ckd_i128_lo(ckd_i128 x)
+{
+  return static_cast<unsigned long long>(x);
+}
+
+inline long long ckd_i128_hi(ckd_i128 x)
+{
+  return static_cast<long long>(x >> 64);
+}
+
+inline ckd_u128 ckd_u128_make(unsigned long long hi, unsigned long long lo)
+{
+  return static_cast<ckd_u128>(hi) << 64 | lo;
+}
+
+inline unsigned long long ckd_u128_lo(ckd_u128 x)
+{
+  return static_cast<unsigned long long>(x);
+}
+
+inline unsigned long long ckd_u128_hi(ckd_u128 x)
+{
+  return static_cast<unsigned long long>(x >> 64);
+}
+
+#  else
+
+#    define ckd_i128_make(hi, lo) \
+      ((ckd_i128)((ckd_u128)(unsigned long long)(hi) << 64 \
+                  | (unsigned long long)(lo)))
+#    define ckd_i128_lo(x) ((unsigned long long)(ckd_i128)(x))
+#    define ckd_i128_hi(x) ((long long)((ckd_i128)(x) >> 64))
+#    define ckd_u128_make(hi, lo) \
+      ((ckd_u128)(unsigned long long)(hi) << 64 | (unsigned long long)(lo))
+#    define ckd_u128_lo(x) ((unsigned long long)(ckd_u128)(x))
+#    define ckd_u128_hi(x) ((unsigned long long)((ckd_u128)(x) >> 64))
+
+#  endif
+
+#elif defined(ckd_have_templates) || defined(ckd_have_generic)
+#  define ckd_have_limbs
+
+typedef struct ckd_limbs
+{
+  unsigned long long lo, hi;
+  int top;
+} ckd_limbs;
+
+#  if defined(ckd_have_templates)
+
+ckd_constexpr ckd_inline ckd_i128 ckd_i128_make(long long hi,
+                                                unsigned long long lo)
+{
+  return {lo, static_cast<unsigned long long>(hi)};
+}
+
+ckd_constexpr ckd_inline unsigned long long ckd_i128_lo(ckd_i128 x)
+{
+  return x.lo;
+}
+
+ckd_constexpr ckd_inline long long ckd_i128_hi(ckd_i128 x)
+{
+  return static_cast<long long>(x.hi);
+}
+
+ckd_constexpr ckd_inline ckd_u128 ckd_u128_make(unsigned long long hi,
+                                                unsigned long long lo)
+{
+  return {lo, hi};
+}
+
+ckd_constexpr ckd_inline unsigned long long ckd_u128_lo(ckd_u128 x)
+{
+  return x.lo;
+}
+
+ckd_constexpr ckd_inline unsigned long long ckd_u128_hi(ckd_u128 x)
+{
+  return x.hi;
+}
+
+template<typename T>
+struct ckd_limbs_signed
+    : std::integral_constant<bool,
+                             std::is_signed<T>::value
+                                 || std::is_same<T, ckd_i128>::value>
+{
+  static_assert(std::is_integral<T>::value || std::is_same<T, ckd_i128>::value
+                    || std::is_same<T, ckd_u128>::value,
+                "non-integral types not allowed");
+  static_assert(!std::is_same<T, bool>::value,
+                "checked booleans not supported");
+  static_assert(!std::is_same<T, char>::value,
+                "unqualified char type is ambiguous");
+};
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_of(std::true_type, long long x)
+{
+  return {static_cast<unsigned long long>(x),
+          static_cast<unsigned long long>(-(x < 0)),
+          -(x < 0)};
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_of(std::false_type,
+                                                unsigned long long x)
+{
+  return {x, 0, 0};
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_of(std::true_type, ckd_i128 x)
+{
+  return {x.lo, x.hi, -static_cast<int>(x.hi >> 63)};
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_of(std::false_type, ckd_u128 x)
+{
+  return {x.lo, x.hi, 0};
+}
+
+template<typename T>
+ckd_constexpr ckd_inline bool ckd_limbs_put(T* res, ckd_limbs z)
+{
+  auto t = static_cast<T>(z.lo);
+  bool n = ckd_limbs_signed<T>::value
+        && static_cast<unsigned long long>(t) >> 63;
+  *res = t;
+  return (static_cast<unsigned long long>(t) != z.lo)
+      | (z.hi != -static_cast<unsigned long long>(n))
+      | (z.top != -static_cast<int>(n));
+}
+
+ckd_constexpr ckd_inline bool ckd_limbs_put(ckd_i128* res, ckd_limbs z)
+{
+  res->lo = z.lo;
+  res->hi = z.hi;
+  return z.top != -static_cast<int>(z.hi >> 63);
+}
+
+ckd_constexpr ckd_inline bool ckd_limbs_put(ckd_u128* res, ckd_limbs z)
+{
+  res->lo = z.lo;
+  res->hi = z.hi;
+  return z.top != 0;
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_add(ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs z = {x.lo + y.lo, 0, 0};
+  bool c = z.lo < x.lo;
+  z.hi = x.hi + y.hi + c;
+  z.top = x.top + y.top + ((z.hi < x.hi) | ((z.hi == x.hi) & c));
+  return z;
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_sub(ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs z = {x.lo - y.lo, 0, 0};
+  bool b = x.lo < y.lo;
+  z.hi = x.hi - y.hi - b;
+  z.top = x.top - y.top - ((x.hi < y.hi) | ((x.hi == y.hi) & b));
+  return z;
+}
+
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_mul64(unsigned long long x,
+                                                   unsigned long long y)
+{
+#    ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 W;
+  W p = static_cast<W>(x) * y;
+  return {static_cast<unsigned long long>(p),
+          static_cast<unsigned long long>(p >> 64),
+          0};
+#    else
+  const unsigned long long m = 0xffffffff;
+  if (!((x | y) >> 32)) {
+    return {x * y, 0, 0};
+  }
+  unsigned long long ll = (x & m) * (y & m);
+  unsigned long long lh = (x & m) * (y >> 32);
+  unsigned long long hl = (x >> 32) * (y & m);
+  unsigned long long hh = (x >> 32) * (y >> 32);
+  unsigned long long mid = (ll >> 32) + (lh & m) + hl;
+  return {mid << 32 | (ll & m), hh + (mid >> 32) + (lh >> 32), 0};
+#    endif
+}
+
+// Multiplies magnitudes, so at most one of the high limbs may be set
+// if the product is to fit in 128 bits.
+ckd_constexpr ckd_inline bool ckd_limbs_umulo(ckd_limbs* z,
+                                              ckd_limbs x,
+                                              ckd_limbs y)
+{
+  *z = ckd_limbs_mul64(x.lo, y.lo);
+  if (!(x.hi | y.hi)) {
+    return false;
+  }
+  ckd_limbs a = ckd_limbs_mul64(x.hi, y.lo);
+  ckd_limbs b = ckd_limbs_mul64(x.lo, y.hi);
+  auto p = z->hi;
+  z->hi += a.lo;
+  bool c = z->hi < p;
+  z->hi += b.lo;
+  c |= z->hi < b.lo;
+  return (!!x.hi & !!y.hi) | !!a.hi | !!b.hi | c;
+}
+
+// Negates the low 128 bits of x if m is all ones, without branching.
+ckd_constexpr ckd_inline void ckd_limbs_neg(ckd_limbs* x, unsigned long long m)
+{
+  x->lo = (x->lo ^ m) - m;
+  x->hi = (x->hi ^ m) + (m & !x->lo);
+}
+
+// A top of 2 means the product is too large for any result type.
+ckd_constexpr ckd_inline ckd_limbs ckd_limbs_mul(ckd_limbs x, ckd_limbs y)
+{
+  auto xm = static_cast<unsigned long long>(x.top);
+  auto ym = static_cast<unsigned long long>(y.top);
+  ckd_limbs_neg(&x, xm);
+  ckd_limbs_neg(&y, ym);
+  ckd_limbs z = {0, 0, 0};
+  bool o = ckd_limbs_umulo(&z, x, y);
+  ckd_limbs_neg(&z, xm ^ ym);
+  z.top = o ? 2 : -((xm != ym) & !!(z.lo | z.hi));
+  return z;
+}
+
+#  elif defined(ckd_have_generic)
+
+ckd_inline ckd_i128 ckd_i128_make(long long hi, unsigned long long lo)
+{
+  ckd_i128 r;
+  r.lo = lo;
+  r.hi = (unsigned long long)hi;
+  return r;
+}
+
+ckd_inline unsigned long long ckd_i128_lo(ckd_i128 x)
+{
+  return x.lo;
+}
+
+ckd_inline long long ckd_i128_hi(ckd_i128 x)
+{
+  return (long long)x.hi;
+}
+
+ckd_inline ckd_u128 ckd_u128_make(unsigned long long hi, unsigned long long lo)
+{
+  ckd_u128 r;
+  r.lo = lo;
+  r.hi = hi;
+  return r;
+}
+
+ckd_inline unsigned long long ckd_u128_lo(ckd_u128 x)
+{
+  return x.lo;
+}
+
+ckd_inline unsigned long long ckd_u128_hi(ckd_u128 x)
+{
+  return x.hi;
+}
+
+ckd_inline ckd_limbs ckd_limbs_sint(ckd_int64 x)
+{
+  ckd_limbs r;
+  r.lo = (ckd_uint64)x;
+  r.hi = -(ckd_uint64)(x < 0);
+  r.top = -(x < 0);
+  return r;
+}
+
+ckd_inline ckd_limbs ckd_limbs_uint(ckd_uint64 x)
+{
+  ckd_limbs r;
+  r.lo = x;
+  r.hi = 0;
+  r.top = 0;
+  return r;
+}
+
+ckd_inline ckd_limbs ckd_limbs_i128(ckd_i128 x)
+{
+  ckd_limbs r;
+  r.lo = x.lo;
+  r.hi = x.hi;
+  r.top = -(int)(x.hi >> 63);
+  return r;
+}
+
+ckd_inline ckd_limbs ckd_limbs_u128(ckd_u128 x)
+{
+  ckd_limbs r;
+  r.lo = x.lo;
+  r.hi = x.hi;
+  r.top = 0;
+  return r;
+}
+
+#    define ckd_declare_limbs_put(S, T) \
+      ckd_inline bool S(void* res, ckd_limbs z) \
+      { \
+        T t = (T)z.lo; \
+        bool n = ckd_is_signed(t) & (int)((ckd_uint64)t >> 63); \
+        *(T*)res = t; \
+        return (bool)(((ckd_uint64)t != z.lo) | (z.hi != -(ckd_uint64)n) \
+                      | (z.top != -(int)n)); \
+      }
+
+ckd_declare_limbs_put(ckd_limbs_put_schar, signed char)
+ckd_declare_limbs_put(ckd_limbs_put_uchar, unsigned char)
+ckd_declare_limbs_put(ckd_limbs_put_sshort, signed short)
+ckd_declare_limbs_put(ckd_limbs_put_ushort, unsigned short)
+ckd_declare_limbs_put(ckd_limbs_put_sint, signed int)
+ckd_declare_limbs_put(ckd_limbs_put_uint, unsigned int)
+ckd_declare_limbs_put(ckd_limbs_put_slong, signed long)
+ckd_declare_limbs_put(ckd_limbs_put_ulong, unsigned long)
+ckd_declare_limbs_put(ckd_limbs_put_slonger, signed long long)
+ckd_declare_limbs_put(ckd_limbs_put_ulonger, unsigned long long)
+
+ckd_inline bool ckd_limbs_put_i128(void* res, ckd_limbs z)
+{
+  ((ckd_i128*)res)->lo = z.lo;
+  ((ckd_i128*)res)->hi = z.hi;
+  return z.top != -(int)(z.hi >> 63);
+}
+
+ckd_inline bool ckd_limbs_put_u128(void* res, ckd_limbs z)
+{
+  ((ckd_u128*)res)->lo = z.lo;
+  ((ckd_u128*)res)->hi = z.hi;
+  return z.top != 0;
+}
+
+ckd_inline ckd_limbs ckd_limbs_add(ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs z;
+  int c;
+  z.lo = x.lo + y.lo;
+  c = z.lo < x.lo;
+  z.hi = x.hi + y.hi + (ckd_uint64)c;
+  z.top = x.top + y.top + ((z.hi < x.hi) | ((z.hi == x.hi) & c));
+  return z;
+}
+
+ckd_inline ckd_limbs ckd_limbs_sub(ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs z;
+  int b;
+  z.lo = x.lo - y.lo;
+  b = x.lo < y.lo;
+  z.hi = x.hi - y.hi - (ckd_uint64)b;
+  z.top = x.top - y.top - ((x.hi < y.hi) | ((x.hi == y.hi) & b));
+  return z;
+}
+
+ckd_inline ckd_limbs ckd_limbs_mul64(ckd_uint64 x, ckd_uint64 y)
+{
+  ckd_limbs r;
+#    ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 W;
+  W p = (W)x * y;
+  r.lo = (ckd_uint64)p;
+  r.hi = (ckd_uint64)(p >> 64);
+  r.top = 0;
+#    else
+  ckd_uint64 m = 0xffffffff;
+  ckd_uint64 ll, lh, hl, hh, mid;
+  r.top = 0;
+  if (!((x | y) >> 32)) {
+    r.lo = x * y;
+    r.hi = 0;
+    return r;
+  }
+  ll = (x & m) * (y & m);
+  lh = (x & m) * (y >> 32);
+  hl = (x >> 32) * (y & m);
+  hh = (x >> 32) * (y >> 32);
+  mid = (ll >> 32) + (lh & m) + hl;
+  r.lo = mid << 32 | (ll & m);
+  r.hi = hh + (mid >> 32) + (lh >> 32);
+#    endif
+  return r;
+}
+
+/* multiplies magnitudes, so at most one of the high limbs may be set
+   if the product is to fit in 128 bits. */
+ckd_inline bool ckd_limbs_umulo(ckd_limbs* z, ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs a, b;
+  ckd_uint64 p;
+  bool c;
+  *z = ckd_limbs_mul64(x.lo, y.lo);
+  if (!(x.hi | y.hi)) {
+    return false;
+  }
+  a = ckd_limbs_mul64(x.hi, y.lo);
+  b = ckd_limbs_mul64(x.lo, y.hi);
+  p = z->hi;
+  z->hi += a.lo;
+  c = z->hi < p;
+  z->hi += b.lo;
+  c |= z->hi < b.lo;
+  return (bool)((!!x.hi & !!y.hi) | !!a.hi | !!b.hi | c);
+}
+
+/* negates the low 128 bits of x if m is all ones, without branching. */
+ckd_inline void ckd_limbs_neg(ckd_limbs* x, ckd_uint64 m)
+{
+  x->lo = (x->lo ^ m) - m;
+  x->hi = (x->hi ^ m) + (m & (ckd_uint64)!x->lo);
+}
+
+/* a top of 2 means the product is too large for any result type. */
+ckd_inline ckd_limbs ckd_limbs_mul(ckd_limbs x, ckd_limbs y)
+{
+  ckd_limbs z;
+  bool o;
+  ckd_uint64 xm = (ckd_uint64)x.top;
+  ckd_uint64 ym = (ckd_uint64)y.top;
+  ckd_limbs_neg(&x, xm);
+  ckd_limbs_neg(&y, ym);
+  o = ckd_limbs_umulo(&z, x, y);
+  ckd_limbs_neg(&z, xm ^ ym);
+  z.top = o ? 2 : -((xm != ym) & !!(z.lo | z.hi));
+  return z;
+}
+
+#    define ckd_narrow(x) _Generic((x), ckd_i128: 0, ckd_u128: 0, default: (x))
+
+#    define ckd_limbs_of(x) \
+      _Generic((x), \
+          signed char: ckd_limbs_sint, \
+          unsigned char: ckd_limbs_uint, \
+          signed short: ckd_limbs_sint, \
+          unsigned short: ckd_limbs_uint, \
+          signed int: ckd_limbs_sint, \
+          unsigned int: ckd_limbs_uint, \
+          signed long: ckd_limbs_sint, \
+          unsigned long: ckd_limbs_uint, \
+          signed long long: ckd_limbs_sint, \
+          unsigned long long: ckd_limbs_uint, \
+          ckd_i128: ckd_limbs_i128, \
+          ckd_u128: ckd_limbs_u128)(x)
+
+#    define ckd_limbs_expr(op, res, a, b) \
+      (_Generic(*res, \
+           signed char: ckd_limbs_put_schar, \
+           unsigned char: ckd_limbs_put_uchar, \
+           signed short: ckd_limbs_put_sshort, \
+           unsigned short: ckd_limbs_put_ushort, \
+           signed int: ckd_limbs_put_sint, \
+           unsigned int: ckd_limbs_put_uint, \
+           signed long: ckd_limbs_put_slong, \
+           unsigned long: ckd_limbs_put_ulong, \
+           signed long long: ckd_limbs_put_slonger, \
+           unsigned long long: ckd_limbs_put_ulonger, \
+           ckd_i128: ckd_limbs_put_i128, \
+           ckd_u128: ckd_limbs_put_u128)( \
+          res, ckd_limbs_##op(ckd_limbs_of(a), ckd_limbs_of(b))))
+
+/* picks the limbs expression if any of the types are limbs. the other
+   one still has to compile, which is what ckd_narrow() is for. */
+#    define ckd_limbs_select(res, a, b, limbs, other) \
+      _Generic(*(res), \
+          ckd_i128: limbs, \
+          ckd_u128: limbs, \
+          default: _Generic((a), \
+              ckd_i128: limbs, \
+              ckd_u128: limbs, \
+              default: _Generic((b), \
+                  ckd_i128: limbs, \
+                  ckd_u128: limbs, \
+                  default: other)))
+
+#  endif
+#endif
+
+#ifndef ckd_narrow
+#  define ckd_narrow(x) (x)
+#endif
+
+#if defined(ckd_have_templates)
+
+template<typename T>
+struct ckd_is_limbs
+    : std::integral_constant<bool,
+#  ifdef ckd_have_limbs
+                             std::is_same<T, ckd_i128>::value
+                                 || std::is_same<T, ckd_u128>::value
+#  else
+                             false
+#  endif
+                             >
+{};
+
+// Only participates in overload resolution when none of the types are
+// limbs, which have overloads of their own.
+template<typename T, typename U, typename V>
+struct ckd_native
+    : std::enable_if<!(ckd_is_limbs<T>::value || ckd_is_limbs<U>::value
+                       || ckd_is_limbs<V>::value),
+                     bool>
+{};
+
+// The polyfill, for backends to use during constant evaluation.
+template<typename T, typename U, typename V>
+struct ckd_poly_ok
+    : std::integral_constant<
+          bool,
+          std::is_integral<T>::value && std::is_integral<U>::value
+              && std::is_integral<V>::value && !std::is_same<T, bool>::value
+              && !std::is_same<U, bool>::value && !std::is_same<V, bool>::value
+              && !std::is_same<T, char>::value && !std::is_same<U, char>::value
+              && !std::is_same<V, char>::value>
+{};
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_poly_add(T* res, U a, V b)
+{
+  return ckd_lane_add(ckd_case<ckd_add_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_poly_sub(T* res, U a, V b)
+{
+  return ckd_lane_sub(
+      ckd_case<ckd_add_case<ckd_uintmax, T, U, V, true>::value>(),
+      res,
+      static_cast<ckd_uintmax>(a),
+      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_poly_mul(T* res, U a, V b)
+{
+  return ckd_lane_mul(ckd_case<ckd_mul_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+#endif
+
+/**
+ * JTCKDINT_OPTION_FLAGS
+ *   = 0: use our bit hacks when the builtins are unavailable
+ *   = 1: use x86-64 carry and overflow flags when builtins are unavailable
+ *
+ * The flags are only consulted when the operands have the signedness
+ * of the result and aren't wider than it, since then the arithmetic can
+ * happen in the result type. Everything else still uses the bit hacks.
+ * These functions can't be used in constant expressions.
+ */
+#if defined(JTCKDINT_OPTION_FLAGS) && JTCKDINT_OPTION_FLAGS == 1 \
+    && defined(__x86_64__) && defined(__GCC_ASM_FLAG_OUTPUTS__) \
+    && (defined(ckd_have_templates) || defined(ckd_have_generic))
+#  define ckd_have_flags
+
+#  if defined(ckd_have_templates)
+
+template<typename T, typename U, typename V>
+struct ckd_flags_ok
+    : std::integral_constant<
+          bool,
+          std::is_integral<T>::value && std::is_integral<U>::value
+              && std::is_integral<V>::value
+              && (sizeof(T) == 4 || sizeof(T) == 8) && sizeof(U) >= 4
+              && sizeof(V) >= 4 && sizeof(U) <= sizeof(T)
+              && sizeof(V) <= sizeof(T)
+              && std::is_signed<T>::value == std::is_signed<U>::value
+              && std::is_signed<T>::value == std::is_signed<V>::value>
+{};
+
+template<typename T>
+ckd_inline bool ckd_asm_add(T* res, T x, T y)
+{
+  bool o;
+  if (std::is_signed<T>::value) {
+    __asm__("add\t%2,%0" : "+r"(x), "=@cco"(o) : "rme"(y));
+  } else {
+    __asm__("add\t%2,%0" : "+r"(x), "=@ccc"(o) : "rme"(y));
+  }
+  *res = x;
+  return o;
+}
+
+template<typename T>
+ckd_inline bool ckd_asm_sub(T* res, T x, T y)
+{
+  bool o;
+  if (std::is_signed<T>::value) {
+    __asm__("sub\t%2,%0" : "+r"(x), "=@cco"(o) : "rme"(y));
+  } else {
+    __asm__("sub\t%2,%0" : "+r"(x), "=@ccc"(o) : "rme"(y));
+  }
+  *res = x;
+  return o;
+}
+
+template<typename T>
+ckd_inline bool ckd_asm_mul(T* res, T x, T y)
+{
+  bool o;
+  if (std::is_signed<T>::value) {
+    __asm__("imul\t%2,%0" : "+r"(x), "=@cco"(o) : "rm"(y));
+  } else {
+    T hi;
+    __asm__("mul\t%3" : "+a"(x), "=d"(hi), "=@cco"(o) : "r"(y));
+    static_cast<void>(hi);
+  }
+  *res = x;
+  return o;
+}
+
+template<typename T, typename U, typename V>
+ckd_inline bool ckd_flags_add(std::true_type, T* res, U a, V b)
+{
+  return ckd_asm_add(res, static_cast<T>(a), static_cast<T>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_flags_add(std::false_type, T* res, U a, V b)
+{
+  return ckd_lane_add(ckd_case<ckd_add_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_inline bool ckd_flags_sub(std::true_type, T* res, U a, V b)
+{
+  return ckd_asm_sub(res, static_cast<T>(a), static_cast<T>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_flags_sub(std::false_type, T* res, U a, V b)
+{
+  return ckd_lane_sub(
+      ckd_case<ckd_add_case<ckd_uintmax, T, U, V, true>::value>(),
+      res,
+      static_cast<ckd_uintmax>(a),
+      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_inline bool ckd_flags_mul(std::true_type, T* res, U a, V b)
+{
+  return ckd_asm_mul(res, static_cast<T>(a), static_cast<T>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_flags_mul(std::false_type, T* res, U a, V b)
+{
+  return ckd_lane_mul(ckd_case<ckd_mul_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+#  elif defined(ckd_have_generic)
+
+#    define ckd_flags_ok(r, a, b) \
+      ((sizeof(r) == 4 || sizeof(r) == 8) && sizeof(a) >= 4 \
+       && sizeof(b) >= 4 && sizeof(a) <= sizeof(r) && sizeof(b) <= sizeof(r) \
+       && ckd_is_signed(a) == ckd_is_signed(r) \
+       && ckd_is_signed(b) == ckd_is_signed(r))
+
+#    define ckd_declare_asm(S, T, OP, CC) \
+      ckd_inline bool S( \
+          void* res, ckd_uintmax a, ckd_uintmax b, unsigned char ab_signed) \
+      { \
+        T x = (T)a; \
+        bool o; \
+        (void)ab_signed; \
+        __asm__(OP "\t%2,%0" : "+r"(x), "=@cc" CC(o) : "rm"((T)b)); \
+        *(T*)res = x; \
+        return o; \
+      }
+
+#    define ckd_declare_asm_umul(S, T) \
+      ckd_inline bool S( \
+          void* res, ckd_uintmax a, ckd_uintmax b, unsigned char ab_signed) \
+      { \
+        T x = (T)a; \
+        T hi; \
+        bool o; \
+        (void)ab_signed; \
+        __asm__("mul\t%3" : "+a"(x), "=d"(hi), "=@cco"(o) : "r"((T)b)); \
+        (void)hi; \
+        *(T*)res = x; \
+        return o; \
+      }
+
+ckd_declare_asm(ckd_add_asm_sint, signed int, "add", "o")
+ckd_declare_asm(ckd_add_asm_uint, unsigned int, "add", "c")
+ckd_declare_asm(ckd_add_asm_slong, signed long, "add", "o")
+ckd_declare_asm(ckd_add_asm_ulong, unsigned long, "add", "c")
+ckd_declare_asm(ckd_add_asm_slonger, signed long long, "add", "o")
+ckd_declare_asm(ckd_add_asm_ulonger, unsigned long long, "add", "c")
+ckd_declare_asm(ckd_sub_asm_sint, signed int, "sub", "o")
+ckd_declare_asm(ckd_sub_asm_uint, unsigned int, "sub", "c")
+ckd_declare_asm(ckd_sub_asm_slong, signed long, "sub", "o")
+ckd_declare_asm(ckd_sub_asm_ulong, unsigned long, "sub", "c")
+ckd_declare_asm(ckd_sub_asm_slonger, signed long long, "sub", "o")
+ckd_declare_asm(ckd_sub_asm_ulonger, unsigned long long, "sub", "c")
+ckd_declare_asm(ckd_mul_asm_sint, signed int, "imul", "o")
+ckd_declare_asm_umul(ckd_mul_asm_uint, unsigned int)
+ckd_declare_asm(ckd_mul_asm_slong, signed long, "imul", "o")
+ckd_declare_asm_umul(ckd_mul_asm_ulong, unsigned long)
+ckd_declare_asm(ckd_mul_asm_slonger, signed long long, "imul", "o")
+ckd_declare_asm_umul(ckd_mul_asm_ulonger, unsigned long long)
+
+#    define ckd_asm_expr(op, res, a, b) \
+      (_Generic(*res, \
+           signed char: ckd_##op##_schar, \
+           unsigned char: ckd_##op##_uchar, \
+           signed short: ckd_##op##_sshort, \
+           unsigned short: ckd_##op##_ushort, \
+           signed int: ckd_##op##_asm_sint, \
+           unsigned int: ckd_##op##_asm_uint, \
+           signed long: ckd_##op##_asm_slong, \
+           unsigned long: ckd_##op##_asm_ulong, \
+           signed long long: ckd_##op##_asm_slonger, \
+           unsigned long long: ckd_##op##_asm_ulonger ckd_generic_int128( \
+               ckd_##op##_sint128, ckd_##op##_uint128) \
+               ckd_generic_limbs(ckd_##op##_slonger, ckd_##op##_ulonger))( \
+          res, \
+          (ckd_uintmax)ckd_narrow(a), \
+          (ckd_uintmax)ckd_narrow(b), \
+          (ckd_is_signed(a) << 1) | ckd_is_signed(b)))
+
+#  endif
+#endif
+
+/**
+ * JTCKDINT_OPTION_LIBRARY
+ *   = 0: inline every ckd_add, ckd_sub and ckd_mul at its call site
+ *   = 1: call out-of-line functions in libjtckdint.a instead
+ *
+ * Which is built by `make lib` from jtckdint.c. C code calls a function
+ * for each result type, which gets the operands widened, along with
+ * their signedness. C++ code calls an instantiation of a template for
+ * each combination of types, which exists for the standard integer
+ * types. The other functions in this header are still inlined.
+ */
+#if defined(JTCKDINT_OPTION_LIBRARY) && JTCKDINT_OPTION_LIBRARY == 1 \
+    && (defined(ckd_have_templates) || defined(ckd_have_generic))
+#  define ckd_have_library
+
+#  if defined(ckd_have_templates)
+
+template<typename T, typename U, typename V>
+bool ckd_lib_add(T* res, U a, V b);
+
+template<typename T, typename U, typename V>
+bool ckd_lib_sub(T* res, U a, V b);
+
+template<typename T, typename U, typename V>
+bool ckd_lib_mul(T* res, U a, V b);
+
+#  else
+
+// Both widths are in the library when it's built with __int128, so it
+// may be linked into code that's built with or without it.
+#    define ckd_lib64(op, S) ckd_lib64_##op##_##S
+#    define ckd_lib128(op, S) ckd_lib128_##op##_##S
+#    ifdef ckd_have_int128
+#      define ckd_lib(op, S) ckd_lib128(op, S)
+#    else
+#      define ckd_lib(op, S) ckd_lib64(op, S)
+#    endif
+
+/* clang-format off */
+#    define ckd_lib_types(F, ...) \
+      F(__VA_ARGS__, schar) F(__VA_ARGS__, uchar) \
+      F(__VA_ARGS__, sshort) F(__VA_ARGS__, ushort) \
+      F(__VA_ARGS__, sint) F(__VA_ARGS__, uint) \
+      F(__VA_ARGS__, slong) F(__VA_ARGS__, ulong) \
+      F(__VA_ARGS__, slonger) F(__VA_ARGS__, ulonger)
+/* clang-format on */
+
+#    define ckd_lib_declare(L, op, S) \
+      bool L(op, S)(void*, ckd_uint64, ckd_uint64, unsigned char);
+ckd_lib_types(ckd_lib_declare, ckd_lib64, add)
+ckd_lib_types(ckd_lib_declare, ckd_lib64, sub)
+ckd_lib_types(ckd_lib_declare, ckd_lib64, mul)
+#    undef ckd_lib_declare
+
+#    ifdef ckd_have_int128
+#      define ckd_lib_declare(L, op, S) \
+        bool L(op, S)(void*, ckd_uintmax, ckd_uintmax, unsigned char);
+ckd_lib_types(ckd_lib_declare, ckd_lib128, add)
+ckd_lib_types(ckd_lib_declare, ckd_lib128, sub)
+ckd_lib_types(ckd_lib_declare, ckd_lib128, mul)
+ckd_lib_declare(ckd_lib128, add, sint128)
+ckd_lib_declare(ckd_lib128, add, uint128)
+ckd_lib_declare(ckd_lib128, sub, sint128)
+ckd_lib_declare(ckd_lib128, sub, uint128)
+ckd_lib_declare(ckd_lib128, mul, sint128)
+ckd_lib_declare(ckd_lib128, mul, uint128)
+#      undef ckd_lib_declare
+#    endif
+
+#  endif
+#endif
+
+/**
+ * JTCKDINT_OPTION_STDCKDINT
+ *   = 0: detect <stdckdint.h>
+ *   = 1: always use <stdckdint.h>
+ *   = 2: never use <stdckdint.h>
+ *
+ * Which is never used with JTCKDINT_OPTION_STATS=1, since its macros
+ * can't be wrapped.
+ */
+#if defined(ckd_have_library) && defined(ckd_have_templates)
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_add(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_add(res, a, b)
+                                     : ckd_lib_add(res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_sub(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_sub(res, a, b)
+                                     : ckd_lib_sub(res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_mul(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_mul(res, a, b)
+                                     : ckd_lib_mul(res, a, b);
+}
+
+#elif defined(ckd_have_library)
+
+#  define ckd_lib_expr(op, res, a, b) \
+    (_Generic(*res, \
+         signed char: ckd_lib(op, schar), \
+         unsigned char: ckd_lib(op, uchar), \
+         signed short: ckd_lib(op, sshort), \
+         unsigned short: ckd_lib(op, ushort), \
+         signed int: ckd_lib(op, sint), \
+         unsigned int: ckd_lib(op, uint), \
+         signed long: ckd_lib(op, slong), \
+         unsigned long: ckd_lib(op, ulong), \
+         signed long long: ckd_lib(op, slonger), \
+         unsigned long long: ckd_lib(op, ulonger) ckd_generic_int128( \
+             ckd_lib(op, sint128), ckd_lib(op, uint128)) \
+             ckd_generic_limbs(ckd_lib(op, slonger), ckd_lib(op, ulonger)))( \
+        res, \
+        (ckd_uintmax)ckd_narrow(a), \
+        (ckd_uintmax)ckd_narrow(b), \
+        (ckd_is_signed(a) << 1) | ckd_is_signed(b)))
+
+#  ifdef ckd_have_limbs
+#    define ckd_base_add(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(add, (res), (a), (b)), \
+                       ckd_lib_expr(add, (res), (a), (b)))
+#    define ckd_base_sub(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(sub, (res), (a), (b)), \
+                       ckd_lib_expr(sub, (res), (a), (b)))
+#    define ckd_base_mul(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(mul, (res), (a), (b)), \
+                       ckd_lib_expr(mul, (res), (a), (b)))
+#  else
+#    define ckd_base_add(res, a, b) ckd_lib_expr(add, (res), (a), (b))
+#    define ckd_base_sub(res, a, b) ckd_lib_expr(sub, (res), (a), (b))
+#    define ckd_base_mul(res, a, b) ckd_lib_expr(mul, (res), (a), (b))
+#  endif
+
+#elif (!defined(JTCKDINT_OPTION_STATS) || JTCKDINT_OPTION_STATS != 1) \
+    && (defined(JTCKDINT_OPTION_STDCKDINT) && JTCKDINT_OPTION_STDCKDINT == 1 \
+        || (!defined(JTCKDINT_OPTION_STDCKDINT) \
+            || JTCKDINT_OPTION_STDCKDINT == 0) \
+            && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L \
+            && ckd_has_include(<stdckdint.h>))
+#  include <stdckdint.h>
+
+#elif defined(ckd_have_templates) \
+    && (defined(ckd_have_constant_evaluated) || defined(ckd_have_limbs)) \
+    && !defined(__STRICT_ANSI__) \
+    && (defined(__GNUC__) && __GNUC__ >= 5 && !defined(__ICC) \
+        || ckd_has_builtin(__builtin_add_overflow) \
+            && ckd_has_builtin(__builtin_sub_overflow) \
+            && ckd_has_builtin(__builtin_mul_overflow))
+
+// Operands the polyfill rejects, i.e. char, bool and enums, are still
+// accepted by the builtins, which GCC and clang evaluate at compile time
+// as well, so they skip the polyfill.
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_add(std::true_type, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_add(res, a, b)
+                                     : __builtin_add_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_add(std::false_type, T* res, U a, V b)
+{
+  return __builtin_add_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_add(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_builtin_add(ckd_poly_ok<T, U, V>(), res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_sub(std::true_type, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_sub(res, a, b)
+                                     : __builtin_sub_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_sub(std::false_type, T* res, U a, V b)
+{
+  return __builtin_sub_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_sub(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_builtin_sub(ckd_poly_ok<T, U, V>(), res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_mul(std::true_type, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated() ? ckd_poly_mul(res, a, b)
+                                     : __builtin_mul_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_builtin_mul(std::false_type, T* res, U a, V b)
+{
+  return __builtin_mul_overflow(a, b, res);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_mul(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_builtin_mul(ckd_poly_ok<T, U, V>(), res, a, b);
+}
+
+#elif !defined(__STRICT_ANSI__) \
+    && (defined(__GNUC__) && __GNUC__ >= 5 && !defined(__ICC) \
+        || ckd_has_builtin(__builtin_add_overflow) \
+            && ckd_has_builtin(__builtin_sub_overflow) \
+            && ckd_has_builtin(__builtin_mul_overflow))
+#  include <stdbool.h>
+
+#  ifdef ckd_have_limbs
+/* only limbs take the polyfill. the builtin still has to compile when
+   it isn't selected, so a limbs result is swapped for a scratch one. */
+#    define ckd_builtin_res(res) \
+      _Generic(*(res), \
+          ckd_i128: &(long long){0}, \
+          ckd_u128: &(unsigned long long){0}, \
+          default: (res))
+#    define ckd_builtin_expr(op, res, x, y) \
+      ckd_limbs_select( \
+          (res), \
+          (x), \
+          (y), \
+          ckd_limbs_expr(op, (res), (x), (y)), \
+          (bool)__builtin_##op##_overflow( \
+              ckd_narrow(x), ckd_narrow(y), ckd_builtin_res(res)))
+#    define ckd_base_add(res, x, y) ckd_builtin_expr(add, res, x, y)
+#    define ckd_base_sub(res, x, y) ckd_builtin_expr(sub, res, x, y)
+#    define ckd_base_mul(res, x, y) ckd_builtin_expr(mul, res, x, y)
+#  else
+#    define ckd_base_add(res, x, y) \
+      ((bool)__builtin_add_overflow((x), (y), (res)))
+#    define ckd_base_sub(res, x, y) \
+      ((bool)__builtin_sub_overflow((x), (y), (res)))
+#    define ckd_base_mul(res, x, y) \
+      ((bool)__builtin_mul_overflow((x), (y), (res)))
+#  endif
+
+#elif defined(ckd_have_templates) && defined(ckd_have_flags)
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_add(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_poly_add(res, a, b)
+             : ckd_flags_add(ckd_flags_ok<T, U, V>(), res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_sub(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_poly_sub(res, a, b)
+             : ckd_flags_sub(ckd_flags_ok<T, U, V>(), res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_mul(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_poly_mul(res, a, b)
+             : ckd_flags_mul(ckd_flags_ok<T, U, V>(), res, a, b);
+}
+
+#elif defined(ckd_have_templates)
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_add(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_lane_add(ckd_case<ckd_add_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_sub(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_lane_sub(
+      ckd_case<ckd_add_case<ckd_uintmax, T, U, V, true>::value>(),
+      res,
+      static_cast<ckd_uintmax>(a),
+      static_cast<ckd_uintmax>(b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_native<T, U, V>::type ckd_mul(T* res,
+                                                                   U a,
+                                                                   V b)
+{
+  return ckd_lane_mul(ckd_case<ckd_mul_case<ckd_uintmax, T, U, V>::value>(),
+                      res,
+                      static_cast<ckd_uintmax>(a),
+                      static_cast<ckd_uintmax>(b));
+}
+
+#elif defined(ckd_have_generic)
+
+#  ifdef ckd_have_flags
+#    define ckd_native_expr(op, res, a, b) \
+      (ckd_flags_ok(*(res), a, b) ? ckd_asm_expr(op, res, a, b) \
+                                  : ckd_expr(op, res, a, b))
+#  else
+#    define ckd_native_expr ckd_expr
+#  endif
+
+#  ifdef ckd_have_limbs
+#    define ckd_base_add(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(add, (res), (a), (b)), \
+                       ckd_native_expr(add, (res), (a), (b)))
+#    define ckd_base_sub(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(sub, (res), (a), (b)), \
+                       ckd_native_expr(sub, (res), (a), (b)))
+#    define ckd_base_mul(res, a, b) \
+      ckd_limbs_select((res), \
+                       (a), \
+                       (b), \
+                       ckd_limbs_expr(mul, (res), (a), (b)), \
+                       ckd_native_expr(mul, (res), (a), (b)))
+#  else
+#    define ckd_base_add(res, a, b) ckd_native_expr(add, (res), (a), (b))
+#    define ckd_base_sub(res, a, b) ckd_native_expr(sub, (res), (a), (b))
+#    define ckd_base_mul(res, a, b) ckd_native_expr(mul, (res), (a), (b))
+#  endif
+
+#  define ckd_expr(op, res, a, b) \
+    (_Generic(*res, \
+         signed char: ckd_##op##_schar, \
+         unsigned char: ckd_##op##_uchar, \
+         signed short: ckd_##op##_sshort, \
+         unsigned short: ckd_##op##_ushort, \
+         signed int: ckd_##op##_sint, \
+         unsigned int: ckd_##op##_uint, \
+         signed long: ckd_##op##_slong, \
+         unsigned long: ckd_##op##_ulong, \
+         signed long long: ckd_##op##_slonger, \
+         unsigned long long: ckd_##op##_ulonger ckd_generic_int128( \
+             ckd_##op##_sint128, ckd_##op##_uint128) \
+             ckd_generic_limbs(ckd_##op##_slonger, ckd_##op##_ulonger))( \
+        res, \
+        (ckd_uintmax)ckd_narrow(a), \
+        (ckd_uintmax)ckd_narrow(b), \
+        (ckd_is_signed(a) << 1) | ckd_is_signed(b)))
+
+#else
+#  pragma message("checked integer arithmetic unsupported in this environment")
+
+#  define ckd_base_add(res, x, y) (*(res) = (x) + (y), 0)
+#  define ckd_base_sub(res, x, y) (*(res) = (x) - (y), 0)
+#  define ckd_base_mul(res, x, y) (*(res) = (x) * (y), 0)
+
+#endif /* stdckdint.h */
+
+// C backends are macros named ckd_base_add etc., so they can be wrapped
+#ifdef ckd_base_add
+#  define ckd_add ckd_base_add
+#  define ckd_sub ckd_base_sub
+#  define ckd_mul ckd_base_mul
+#endif
+
+#if defined(ckd_have_limbs) && defined(ckd_have_templates) && !defined(ckd_add)
+
+template<typename T, typename U, typename V>
+struct ckd_with_limbs
+    : std::enable_if<ckd_is_limbs<T>::value || ckd_is_limbs<U>::value
+                         || ckd_is_limbs<V>::value,
+                     bool>
+{};
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_with_limbs<T, U, V>::type
+ckd_add(T* res, U a, V b)
+{
+  return ckd_limbs_put(
+      res,
+      ckd_limbs_add(ckd_limbs_of(ckd_limbs_signed<U>(), a),
+                    ckd_limbs_of(ckd_limbs_signed<V>(), b)));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_with_limbs<T, U, V>::type
+ckd_sub(T* res, U a, V b)
+{
+  return ckd_limbs_put(
+      res,
+      ckd_limbs_sub(ckd_limbs_of(ckd_limbs_signed<U>(), a),
+                    ckd_limbs_of(ckd_limbs_signed<V>(), b)));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline typename ckd_with_limbs<T, U, V>::type
+ckd_mul(T* res, U a, V b)
+{
+  return ckd_limbs_put(
+      res,
+      ckd_limbs_mul(ckd_limbs_of(ckd_limbs_signed<U>(), a),
+                    ckd_limbs_of(ckd_limbs_signed<V>(), b)));
+}
+
+#endif
+
+/*
+ * Span functions. Every lane is computed branch-free with the polyfill
+ * bit hacks, and a block of lanes is only searched when one overflows.
+ */
+
+#if defined(ckd_have_templates)
+#  if ckd_has_include(<span>) \
+      && (__cplusplus >= 202002L \
+          || defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#    include <span>
+#  endif
+
+#  define ckd_lanes 64
+
+template<typename T, typename U, typename V>
+struct ckd_lane
+{
+  static const bool narrow = sizeof(T) <= sizeof(unsigned)
+      && sizeof(U) <= sizeof(unsigned) && sizeof(V) <= sizeof(unsigned);
+  static const bool wide = sizeof(T) <= sizeof(unsigned long long)
+      && sizeof(U) <= sizeof(unsigned long long)
+      && sizeof(V) <= sizeof(unsigned long long);
+  typedef typename std::conditional<
+      narrow,
+      unsigned,
+      typename std::conditional<wide, unsigned long long, ckd_uintmax>::type>::
+      type type;
+};
+
+struct ckd_op_add
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_add<L>(res, a, b);
+  }
+};
+
+struct ckd_op_sub
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_sub<L>(res, a, b);
+  }
+};
+
+struct ckd_op_mul
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_mul<L>(res, a, b);
+  }
+};
+
+template<typename F, typename T, typename U, typename V>
+inline std::size_t ckd_expr_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  typedef typename ckd_lane<T, U, V>::type L;
+  std::size_t first = n;
+  for (std::size_t i = 0; i < n; i += ckd_lanes) {
+    std::size_t m = n - i < ckd_lanes ? n - i : ckd_lanes;
+    unsigned char f[ckd_lanes];
+    unsigned char o = 0;
+    for (std::size_t k = 0; k != m; ++k) {
+      f[k] = F::template apply<L>(res + i + k, a[i + k], b[i + k]);
+      o |= f[k];
+    }
+    if (o && first == n) {
+      std::size_t k = 0;
+      while (!f[k]) {
+        ++k;
+      }
+      first = i + k;
+    }
+  }
+  return first;
+}
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_add_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_add>(res, a, b, n);
+}
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_sub_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_sub>(res, a, b, n);
+}
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_mul_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_mul>(res, a, b, n);
+}
+
+#  ifdef __cpp_lib_span
+inline std::size_t ckd_span_size(std::size_t n, std::size_t m, std::size_t k)
+{
+  return n < m ? (n < k ? n : k) : (m < k ? m : k);
+}
+
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_add_n(std::span<T, N> res,
+                             std::span<U, M> a,
+                             std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_add>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_sub_n(std::span<T, N> res,
+                             std::span<U, M> a,
+                             std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_sub>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_mul_n(std::span<T, N> res,
+                             std::span<U, M> a,
+                             std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_mul>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+#  endif
+
+#elif defined(ckd_have_extras)
+
+#  define ckd_lanes 64
+
+#  define ckd_add_n(res, a, b, n) ckd_expr_n(add, (res), (a), (b), (n))
+#  define ckd_sub_n(res, a, b, n) ckd_expr_n(sub, (res), (a), (b), (n))
+#  define ckd_mul_n(res, a, b, n) ckd_expr_n(mul, (res), (a), (b), (n))
+
+#  define ckd_type_code(x) \
+    _Generic(x, \
+        unsigned char: 0, \
+        signed char: 1, \
+        unsigned short: 2, \
+        signed short: 3, \
+        unsigned int: 4, \
+        signed int: 5, \
+        unsigned long: 6, \
+        signed long: 7, \
+        unsigned long long: 8, \
+        signed long long: 9 ckd_generic_int128(11, 10))
+
+#  define ckd_expr_n(op, res, a, b, n) \
+    (_Generic(*res, \
+         signed char: ckd_##op##_n_schar, \
+         unsigned char: ckd_##op##_n_uchar, \
+         signed short: ckd_##op##_n_sshort, \
+         unsigned short: ckd_##op##_n_ushort, \
+         signed int: ckd_##op##_n_sint, \
+         unsigned int: ckd_##op##_n_uint, \
+         signed long: ckd_##op##_n_slong, \
+         unsigned long: ckd_##op##_n_ulong, \
+         signed long long: ckd_##op##_n_slonger, \
+         unsigned long long: ckd_##op##_n_ulonger ckd_generic_int128( \
+             ckd_##op##_n_sint128, ckd_##op##_n_uint128))( \
+        res, a, ckd_type_code(*(a)), b, ckd_type_code(*(b)), n))
+
+#  define ckd_load_case(c, T, L) \
+    case c: \
+      for (k = 0; k != m; ++k) { \
+        x[k] = (L)((T const*)p)[i + k]; \
+      } \
+      break;
+
+#  define ckd_declare_load(S, L, I128, D) \
+    ckd_inline void S( \
+        L* x, void const* p, unsigned char p_type, size_t i, size_t m) \
+    { \
+      size_t k; \
+      switch (p_type) { \
+        ckd_load_case(0, unsigned char, L) \
+        ckd_load_case(1, signed char, L) \
+        ckd_load_case(2, unsigned short, L) \
+        ckd_load_case(3, signed short, L) \
+        ckd_load_case(4, unsigned int, L) \
+        ckd_load_case(5, signed int, L) \
+        ckd_load_case(6, unsigned long, L) \
+        ckd_load_case(7, signed long, L) \
+        ckd_load_case(8, unsigned long long, L) \
+        I128 \
+        default: /* widest signed type */ \
+          for (k = 0; k != m; ++k) { \
+            x[k] = (L)((D const*)p)[i + k]; \
+          } \
+          break; \
+      } \
+    }
+
+#  ifdef ckd_have_int128
+#    define ckd_lane64(op, S) ckd_##op##64_##S
+ckd_declare_load(ckd_load_n,
+                 ckd_uintmax,
+                 ckd_load_case(9, signed long long, ckd_uintmax)
+                     ckd_load_case(10, unsigned __int128, ckd_uintmax),
+                 signed __int128)
+ckd_declare_load(ckd_load64_n, ckd_uint64, , signed long long)
+#  else
+#    define ckd_lane64(op, S) ckd_##op##_##S
+#    define ckd_load64_n ckd_load_n
+ckd_declare_load(ckd_load_n, ckd_uintmax, , signed long long)
+#  endif
+
+#  define ckd_lane_n(F, ab_signed) \
+    for (k = 0; k != m; ++k) { \
+      f[k] = F(res + i + k, x[k], y[k], ab_signed); \
+      o |= f[k]; \
+    } \
+    break;
+
+#  define ckd_lanes_n(L, F, LOAD) \
+    do { \
+      L x[ckd_lanes]; \
+      L y[ckd_lanes]; \
+      unsigned char f[ckd_lanes] = {0}; \
+      size_t i; \
+      size_t k; \
+      size_t m; \
+      size_t first = n; \
+      for (i = 0; i < n; i += m) { \
+        unsigned char o = 0; \
+        m = n - i < ckd_lanes ? n - i : ckd_lanes; \
+        LOAD(x, a, a_type, i, m); \
+        LOAD(y, b, b_type, i, m); \
+        switch ((a_type & 1) << 1 | (b_type & 1)) { \
+          case 0: \
+            ckd_lane_n(F, 0) \
+          case 1: \
+            ckd_lane_n(F, 1) \
+          case 2: \
+            ckd_lane_n(F, 2) \
+          case 3: \
+            ckd_lane_n(F, 3) \
+          default: \
+            ckd_unreachable(0); \
+        } \
+        if (o && first == n) { \
+          for (k = 0; !f[k]; ++k) { \
+          } \
+          first = i + k; \
+        } \
+      } \
+      return first; \
+    } while (0)
+
+#  define ckd_declare_n(op, S, T) \
+    static inline size_t ckd_##op##_n_##S(T* res, \
+                                          void const* a, \
+                                          unsigned char a_type, \
+                                          void const* b, \
+                                          unsigned char b_type, \
+                                          size_t n) \
+    { \
+      if (a_type < 10 && b_type < 10) { \
+        ckd_lanes_n(ckd_uint64, ckd_lane64(op, S), ckd_load64_n); \
+      } \
+      ckd_lanes_n(ckd_uintmax, ckd_##op##_##S, ckd_load_n); \
+    }
+
+/* when a and b are both T, exact results fit in W and need no bit hacks */
+#  define ckd_declare_exact_n(op, S, T, W, OP) \
+    static inline size_t ckd_##op##_n_##S(T* res, \
+                                          void const* a, \
+                                          unsigned char a_type, \
+                                          void const* b, \
+                                          unsigned char b_type, \
+                                          size_t n) \
+    { \
+      if (a_type == ckd_type_code((T)0) && b_type == a_type) { \
+        T const* p = (T const*)a; \
+        T const* q = (T const*)b; \
+        unsigned char f[ckd_lanes] = {0}; \
+        size_t i; \
+        size_t k; \
+        size_t m; \
+        size_t first = n; \
+        for (i = 0; i < n; i += m) { \
+          unsigned char o = 0; \
+          m = n - i < ckd_lanes ? n - i : ckd_lanes; \
+          for (k = 0; k != m; ++k) { \
+            W z = (W)p[i + k] OP (W)q[i + k]; \
+            res[i + k] = (T)z; \
+            f[k] = z != (W)(T)z; \
+            o |= f[k]; \
+          } \
+          if (o && first == n) { \
+            for (k = 0; !f[k]; ++k) { \
+            } \
+            first = i + k; \
+          } \
+        } \
+        return first; \
+      } \
+      if (a_type < 10 && b_type < 10) { \
+        ckd_lanes_n(ckd_uint64, ckd_lane64(op, S), ckd_load64_n); \
+      } \
+      ckd_lanes_n(ckd_uintmax, ckd_##op##_##S, ckd_load_n); \
+    }
+
+#  define ckd_declare_n128(op, S, T) \
+    static inline size_t ckd_##op##_n_##S(T* res, \
+                                          void const* a, \
+                                          unsigned char a_type, \
+                                          void const* b, \
+                                          unsigned char b_type, \
+                                          size_t n) \
+    { \
+      ckd_lanes_n(ckd_uintmax, ckd_##op##_##S, ckd_load_n); \
+    }
+
+ckd_declare_exact_n(add, schar, signed char, int, +)
+ckd_declare_exact_n(add, uchar, unsigned char, int, +)
+ckd_declare_exact_n(add, sshort, signed short, int, +)
+ckd_declare_exact_n(add, ushort, unsigned short, int, +)
+ckd_declare_exact_n(add, sint, signed int, ckd_int64, +)
+ckd_declare_exact_n(add, uint, unsigned int, ckd_int64, +)
+ckd_declare_n(add, slong, signed long)
+ckd_declare_n(add, ulong, unsigned long)
+ckd_declare_n(add, slonger, signed long long)
+ckd_declare_n(add, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(add, sint128, signed __int128)
+ckd_declare_n128(add, uint128, unsigned __int128)
+#  endif
+
+ckd_declare_exact_n(sub, schar, signed char, int, -)
+ckd_declare_exact_n(sub, uchar, unsigned char, int, -)
+ckd_declare_exact_n(sub, sshort, signed short, int, -)
+ckd_declare_exact_n(sub, ushort, unsigned short, int, -)
+ckd_declare_exact_n(sub, sint, signed int, ckd_int64, -)
+ckd_declare_exact_n(sub, uint, unsigned int, ckd_int64, -)
+ckd_declare_n(sub, slong, signed long)
+ckd_declare_n(sub, ulong, unsigned long)
+ckd_declare_n(sub, slonger, signed long long)
+ckd_declare_n(sub, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(sub, sint128, signed __int128)
+ckd_declare_n128(sub, uint128, unsigned __int128)
+#  endif
+
+ckd_declare_exact_n(mul, schar, signed char, int, *)
+ckd_declare_exact_n(mul, uchar, unsigned char, int, *)
+ckd_declare_exact_n(mul, sshort, signed short, int, *)
+ckd_declare_exact_n(mul, ushort, unsigned short, ckd_int64, *)
+ckd_declare_exact_n(mul, sint, signed int, ckd_int64, *)
+ckd_declare_exact_n(mul, uint, unsigned int, ckd_uint64, *)
+ckd_declare_n(mul, slong, signed long)
+ckd_declare_n(mul, ulong, unsigned long)
+ckd_declare_n(mul, slonger, signed long long)
+ckd_declare_n(mul, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(mul, sint128, signed __int128)
+ckd_declare_n128(mul, uint128, unsigned __int128)
+#  endif
+
+#endif
+
+/*
+ * Reductions. These give the same result and flag as a chain of scalar
+ * calls starting from zero, which for ckd_dot() looks like this:
+ *
+ *     for (i = 0; i < n; ++i) {
+ *       o |= ckd_mul(&p, a[i], b[i]);
+ *       o |= ckd_add(&z, z, p);
+ *     }
+ *
+ * Each block of terms is computed by the span functions and summed in
+ * a lane wider than T. When neither the positive nor negative half of
+ * a block is able to take the total out of range, no prefix inside it
+ * could have either, so the chain only needs to be replayed for blocks
+ * which come close to overflowing.
+ */
+
+#if defined(ckd_have_templates)
+
+template<typename T>
+struct ckd_wide
+{
+  typedef typename std::conditional<(sizeof(T) < sizeof(long long)),
+                                    long long,
+                                    ckd_intmax>::type type;
+};
+
+template<typename T>
+inline bool ckd_fold(T* acc, T const* t, std::size_t m)
+{
+  typedef typename ckd_wide<T>::type W;
+  if (sizeof(W) <= sizeof(T)) {
+    return false;
+  }
+  W pos = 0;
+  W neg = 0;
+  for (std::size_t k = 0; k != m; ++k) {
+    W v = static_cast<W>(t[k]);
+    pos += v > 0 ? v : 0;
+    neg += v < 0 ? v : 0;
+  }
+  W s = static_cast<W>(*acc);
+  if (static_cast<W>(static_cast<T>(s + pos)) != s + pos
+      || static_cast<W>(static_cast<T>(s + neg)) != s + neg)
+  {
+    return false;
+  }
+  *acc = static_cast<T>(s + pos + neg);
+  return true;
+}
+
+template<typename T, typename U>
+inline bool ckd_sum(T* res, U const* a, std::size_t n)
+{
+  static unsigned char const zero[ckd_lanes] = {};
+  T t[ckd_lanes];
+  T acc = 0;
+  bool o = false;
+  for (std::size_t i = 0; i < n; i += ckd_lanes) {
+    std::size_t m = n - i < ckd_lanes ? n - i : ckd_lanes;
+    if (o || ckd_add_n(t, a + i, zero, m) != m || !ckd_fold(&acc, t, m)) {
+      for (std::size_t k = 0; k != m; ++k) {
+        o |= ckd_add(&acc, acc, a[i + k]);
+      }
+    }
+  }
+  *res = acc;
+  return o;
+}
+
+template<typename T, typename U, typename V>
+inline bool ckd_dot(T* res, U const* a, V const* b, std::size_t n)
+{
+  T t[ckd_lanes];
+  T acc = 0;
+  bool o = false;
+  for (std::size_t i = 0; i < n; i += ckd_lanes) {
+    std::size_t m = n - i < ckd_lanes ? n - i : ckd_lanes;
+    if (o || ckd_mul_n(t, a + i, b + i, m) != m || !ckd_fold(&acc, t, m)) {
+      for (std::size_t k = 0; k != m; ++k) {
+        T p = 0;
+        o |= ckd_mul(&p, a[i + k], b[i + k]);
+        o |= ckd_add(&acc, acc, p);
+      }
+    }
+  }
+  *res = acc;
+  return o;
+}
+
+#  ifdef __cpp_lib_span
+template<typename T, typename U, std::size_t M>
+inline bool ckd_sum(T* res, std::span<U, M> a)
+{
+  return ckd_sum(res, a.data(), a.size());
+}
+
+template<typename T, typename U, std::size_t M, typename V, std::size_t K>
+inline bool ckd_dot(T* res, std::span<U, M> a, std::span<V, K> b)
+{
+  return ckd_dot(
+      res, a.data(), b.data(), a.size() < b.size() ? a.size() : b.size());
+}
+#  endif
+
+#elif defined(ckd_have_extras)
+
+#  define ckd_sum(res, a, n) \
+    (_Generic(*res, \
+         signed char: ckd_sum_schar, \
+         unsigned char: ckd_sum_uchar, \
+         signed short: ckd_sum_sshort, \
+         unsigned short: ckd_sum_ushort, \
+         signed int: ckd_sum_sint, \
+         unsigned int: ckd_sum_uint, \
+         signed long: ckd_sum_slong, \
+         unsigned long: ckd_sum_ulong, \
+         signed long long: ckd_sum_slonger, \
+         unsigned long long: ckd_sum_ulonger ckd_generic_int128( \
+             ckd_sum_sint128, ckd_sum_uint128))( \
+        res, a, ckd_type_code(*(a)), n))
+
+#  define ckd_dot(res, a, b, n) ckd_expr_n(dot, (res), (a), (b), (n))
+
+ckd_inline size_t ckd_type_size(unsigned char type)
+{
+  switch (type >> 1) {
+    case 0:
+      return sizeof(char);
+    case 1:
+      return sizeof(short);
+    case 2:
+      return sizeof(int);
+    case 3:
+      return sizeof(long);
+    case 4:
+      return sizeof(long long);
+    default:
+      return sizeof(ckd_uintmax);
+  }
+}
+
+#  define ckd_offset(p, type, i) \
+    ((void const*)((char const*)(p) + (i) * ckd_type_size(type)))
+
+#  define ckd_declare_reduce(S, T, W) \
+    ckd_inline bool ckd_fold_##S(T* acc, T const* t, size_t m) \
+    { \
+      W pos = 0; \
+      W neg = 0; \
+      W s = (W)*acc; \
+      size_t k; \
+      if (sizeof(W) <= sizeof(T)) { \
+        return false; \
+      } \
+      for (k = 0; k != m; ++k) { \
+        W v = (W)t[k]; \
+        pos += v > 0 ? v : 0; \
+        neg += v < 0 ? v : 0; \
+      } \
+      if ((W)(T)(s + pos) != s + pos || (W)(T)(s + neg) != s + neg) { \
+        return false; \
+      } \
+      *acc = (T)(s + pos + neg); \
+      return true; \
+    } \
+    static inline bool ckd_sum_##S( \
+        T* res, void const* a, unsigned char a_type, size_t n) \
+    { \
+      unsigned char const zero[ckd_lanes] = {0}; \
+      unsigned char ab_signed = \
+          (unsigned char)(ckd_is_signed((T)0) << 1 | (a_type & 1)); \
+      ckd_uintmax x[ckd_lanes]; \
+      T t[ckd_lanes]; \
+      T acc = 0; \
+      bool o = false; \
+      size_t i; \
+      size_t k; \
+      size_t m; \
+      for (i = 0; i < n; i += m) { \
+        m = n - i < ckd_lanes ? n - i : ckd_lanes; \
+        if (o \
+            || ckd_add_n_##S(t, ckd_offset(a, a_type, i), a_type, zero, 0, m) \
+                != m \
+            || !ckd_fold_##S(&acc, t, m)) \
+        { \
+          ckd_load_n(x, a, a_type, i, m); \
+          for (k = 0; k != m; ++k) { \
+            o |= ckd_add_##S(&acc, (ckd_uintmax)acc, x[k], ab_signed); \
+          } \
+        } \
+      } \
+      *res = acc; \
+      return o; \
+    } \
+    static inline bool ckd_dot_n_##S(T* res, \
+                                     void const* a, \
+                                     unsigned char a_type, \
+                                     void const* b, \
+                                     unsigned char b_type, \
+                                     size_t n) \
+    { \
+      unsigned char ab_signed = \
+          (unsigned char)((a_type & 1) << 1 | (b_type & 1)); \
+      unsigned char tt_signed = (unsigned char)(ckd_is_signed((T)0) * 3); \
+      ckd_uintmax x[ckd_lanes]; \
+      ckd_uintmax y[ckd_lanes]; \
+      T t[ckd_lanes]; \
+      T acc = 0; \
+      bool o = false; \
+      size_t i; \
+      size_t k; \
+      size_t m; \
+      for (i = 0; i < n; i += m) { \
+        m = n - i < ckd_lanes ? n - i : ckd_lanes; \
+        if (o \
+            || ckd_mul_n_##S(t, \
+                             ckd_offset(a, a_type, i), \
+                             a_type, \
+                             ckd_offset(b, b_type, i), \
+                             b_type, \
+                             m) \
+                != m \
+            || !ckd_fold_##S(&acc, t, m)) \
+        { \
+          ckd_load_n(x, a, a_type, i, m); \
+          ckd_load_n(y, b, b_type, i, m); \
+          for (k = 0; k != m; ++k) { \
+            T p = 0; \
+            o |= ckd_mul_##S(&p, x[k], y[k], ab_signed); \
+            o |= ckd_add_##S( \
+                &acc, (ckd_uintmax)acc, (ckd_uintmax)p, tt_signed); \
+          } \
+        } \
+      } \
+      *res = acc; \
+      return o; \
+    }
+
+ckd_declare_reduce(schar, signed char, ckd_int64)
+ckd_declare_reduce(uchar, unsigned char, ckd_int64)
+ckd_declare_reduce(sshort, signed short, ckd_int64)
+ckd_declare_reduce(ushort, unsigned short, ckd_int64)
+ckd_declare_reduce(sint, signed int, ckd_int64)
+ckd_declare_reduce(uint, unsigned int, ckd_int64)
+ckd_declare_reduce(slong, signed long, ckd_intmax)
+ckd_declare_reduce(ulong, unsigned long, ckd_intmax)
+ckd_declare_reduce(slonger, signed long long, ckd_intmax)
+ckd_declare_reduce(ulonger, unsigned long long, ckd_intmax)
+#  ifdef ckd_have_int128
+ckd_declare_reduce(sint128, signed __int128, ckd_intmax)
+ckd_declare_reduce(uint128, unsigned __int128, ckd_intmax)
+#  endif
+
+#endif
+
+/*
+ * Fused arithmetic. These compute the exact value of the expression,
+ * which is checked once when it's stored. When the terms are too small
+ * to overflow the lane, they're simply added together in it. If every
+ * operand is unsigned, the lane is checked with ckd_mul() and ckd_add()
+ * so it can use the builtins. Otherwise a sign and a magnitude that's
+ * twice the lane width are accumulated.
+ */
+
+#if defined(ckd_have_templates)
+
+template<typename T>
+struct ckd_bits
+    : std::integral_constant<int,
+                             static_cast<int>(sizeof(T) * 8)
+                                 - std::is_signed<T>::value>
+{};
+
+template<typename T, typename U, typename V, typename W, typename X, typename Y>
+struct ckd_fused_lane
+{
+  typedef typename std::conditional<
+      (sizeof(T) <= sizeof(unsigned long long)
+       && sizeof(U) <= sizeof(unsigned long long)
+       && sizeof(V) <= sizeof(unsigned long long)
+       && sizeof(W) <= sizeof(unsigned long long)
+       && sizeof(X) <= sizeof(unsigned long long)
+       && sizeof(Y) <= sizeof(unsigned long long)),
+      unsigned long long,
+      ckd_uintmax>::type type;
+};
+
+template<typename L>
+ckd_constexpr ckd_inline L ckd_umul_wide(L* hi, L x, L y)
+{
+  const int h = static_cast<int>(sizeof(L) * 4);
+  const L m = static_cast<L>((static_cast<L>(1) << h) - 1);
+  if (!((x | y) >> h)) {
+    *hi = 0;
+    return static_cast<L>(x * y);
+  }
+  L ll = static_cast<L>((x & m) * (y & m));
+  L lh = static_cast<L>((x & m) * (y >> h));
+  L hl = static_cast<L>((x >> h) * (y & m));
+  L mid = static_cast<L>((ll >> h) + (lh & m) + (hl & m));
+  *hi = static_cast<L>((x >> h) * (y >> h) + (lh >> h) + (hl >> h)
+                       + (mid >> h));
+  return static_cast<L>((mid << h) | (ll & m));
+}
+
+template<typename L>
+struct ckd_acc
+{
+  L lo;
+  L hi;
+  bool neg;
+  bool o;
+};
+
+template<typename L, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_acc_mul(ckd_acc<L>* s, U a, V b)
+{
+  typedef typename std::make_signed<L>::type SL;
+  auto x = static_cast<L>(a);
+  auto y = static_cast<L>(b);
+  bool n = false;
+  if (std::is_signed<U>::value && static_cast<SL>(x) < 0) {
+    x = static_cast<L>(-x);
+    n = !n;
+  }
+  if (std::is_signed<V>::value && static_cast<SL>(y) < 0) {
+    y = static_cast<L>(-y);
+    n = !n;
+  }
+  L hi = 0;
+  L lo = ckd_umul_wide(&hi, x, y);
+  if (n == s->neg) {
+    s->lo = static_cast<L>(s->lo + lo);
+    auto c = static_cast<L>(s->lo < lo);
+    auto h = static_cast<L>(s->hi + hi);
+    s->o |= h < hi;
+    s->hi = static_cast<L>(h + c);
+    s->o |= s->hi < c;
+  } else if (s->hi > hi || (s->hi == hi && s->lo >= lo)) {
+    s->hi = static_cast<L>(s->hi - hi - static_cast<L>(s->lo < lo));
+    s->lo = static_cast<L>(s->lo - lo);
+  } else {
+    s->hi = static_cast<L>(hi - s->hi - static_cast<L>(lo < s->lo));
+    s->lo = static_cast<L>(lo - s->lo);
+    s->neg = n;
+  }
+}
+
+template<typename L,
+         typename T,
+         typename U,
+         typename V,
+         typename W,
+         typename X,
+         typename Y>
+ckd_constexpr ckd_inline bool ckd_lane_muladd(T* res, U a, V b, W c, X d, Y e)
+{
+  static_assert(std::is_integral<T>::value && std::is_integral<U>::value
+                    && std::is_integral<V>::value && std::is_integral<W>::value
+                    && std::is_integral<X>::value && std::is_integral<Y>::value,
+                "non-integral types not allowed");
+  static_assert(!std::is_same<T, bool>::value && !std::is_same<U, bool>::value
+                    && !std::is_same<V, bool>::value
+                    && !std::is_same<W, bool>::value
+                    && !std::is_same<X, bool>::value
+                    && !std::is_same<Y, bool>::value,
+                "checked booleans not supported");
+  static_assert(!std::is_same<T, char>::value && !std::is_same<U, char>::value
+                    && !std::is_same<V, char>::value
+                    && !std::is_same<W, char>::value
+                    && !std::is_same<X, char>::value
+                    && !std::is_same<Y, char>::value,
+                "unqualified char type is ambiguous");
+  typedef typename std::make_signed<L>::type SL;
+  const int n = static_cast<int>(sizeof(L) * 8);
+  const int ab = ckd_bits<U>::value + ckd_bits<V>::value;
+  const int cd = ckd_bits<W>::value + ckd_bits<X>::value;
+  const int ee = ckd_bits<Y>::value;
+  auto m = static_cast<L>((std::numeric_limits<T>::max)());
+  if (ab <= n - 2 && cd <= n - 2 && ee <= n - 2
+      && (ab > n - 3) + (cd > n - 3) + (ee > n - 3) <= 1)
+  {
+    auto z = static_cast<SL>(static_cast<SL>(static_cast<L>(a))
+                                 * static_cast<SL>(static_cast<L>(b))
+                             + static_cast<SL>(static_cast<L>(c))
+                                 * static_cast<SL>(static_cast<L>(d))
+                             + static_cast<SL>(static_cast<L>(e)));
+    *res = static_cast<T>(z);
+    if (std::is_signed<T>::value) {
+      return z != static_cast<SL>(*res);
+    } else {
+      return (z < 0) | (static_cast<L>(z) > m);
+    }
+  }
+  if (!std::is_signed<U>::value && !std::is_signed<V>::value
+      && !std::is_signed<W>::value && !std::is_signed<X>::value
+      && !std::is_signed<Y>::value)
+  {
+    L p = 0;
+    L q = 0;
+    L z = 0;
+    bool o = ckd_mul(&p, static_cast<L>(a), static_cast<L>(b));
+    o |= ckd_mul(&q, static_cast<L>(c), static_cast<L>(d));
+    o |= ckd_add(&z, p, q);
+    o |= ckd_add(&z, z, static_cast<L>(e));
+    *res = static_cast<T>(z);
+    return o | (z > m);
+  }
+  ckd_acc<L> s = {0, 0, false, false};
+  ckd_acc_mul(&s, a, b);
+  ckd_acc_mul(&s, c, d);
+  ckd_acc_mul(&s, e, 1u);
+  if (s.neg) {
+    m = std::is_signed<T>::value ? static_cast<L>(m + 1) : 0;
+  }
+  *res = static_cast<T>(s.neg ? static_cast<L>(-s.lo) : s.lo);
+  return s.o | !!s.hi | (s.lo > m);
+}
+
+template<typename T, typename U, typename V, typename W>
+ckd_constexpr ckd_inline bool ckd_muladd(T* res, U a, V b, W c)
+{
+  typedef unsigned char Z;
+  typedef typename ckd_fused_lane<T, U, V, W, Z, Z>::type L;
+  return ckd_lane_muladd<L>(res, a, b, static_cast<Z>(0), static_cast<Z>(0), c);
+}
+
+template<typename T,
+         typename U,
+         typename V,
+         typename W,
+         typename X,
+         typename Y>
+ckd_constexpr ckd_inline bool ckd_muladd2(T* res, U a, V b, W c, X d, Y e)
+{
+  typedef typename ckd_fused_lane<T, U, V, W, X, Y>::type L;
+  return ckd_lane_muladd<L>(res, a, b, c, d, e);
+}
+
+#elif defined(ckd_have_extras)
+
+#  define ckd_muladd(res, a, b, c) \
+    ckd_muladd2(res, a, b, (unsigned char)0, (unsigned char)0, c)
+
+#  define ckd_bits(x) ((int)sizeof(x) * 8 - ckd_is_signed(x))
+
+#  define ckd_muladd_narrow(L, a, b, c, d, e) \
+    (ckd_bits(a) + ckd_bits(b) <= (int)sizeof(L) * 8 - 2 \
+     && ckd_bits(c) + ckd_bits(d) <= (int)sizeof(L) * 8 - 2 \
+     && ckd_bits(e) <= (int)sizeof(L) * 8 - 2 \
+     && (ckd_bits(a) + ckd_bits(b) > (int)sizeof(L) * 8 - 3) \
+                + (ckd_bits(c) + ckd_bits(d) > (int)sizeof(L) * 8 - 3) \
+                + (ckd_bits(e) > (int)sizeof(L) * 8 - 3) \
+            <= 1)
+
+#  define ckd_muladd_signs(a, b, c, d, e) \
+    (ckd_is_signed(a) << 4 | ckd_is_signed(b) << 3 | ckd_is_signed(c) << 2 \
+     | ckd_is_signed(d) << 1 | ckd_is_signed(e))
+
+#  define ckd_muladd_expr(P, L, res, a, b, c, d, e) \
+    (_Generic(*res, \
+         signed char: P##_schar, \
+         unsigned char: P##_uchar, \
+         signed short: P##_sshort, \
+         unsigned short: P##_ushort, \
+         signed int: P##_sint, \
+         unsigned int: P##_uint, \
+         signed long: P##_slong, \
+         unsigned long: P##_ulong, \
+         signed long long: P##_slonger, \
+         unsigned long long: P##_ulonger ckd_generic_int128( \
+             ckd_muladd_sint128, ckd_muladd_uint128))( \
+        res, \
+        (L)(a), \
+        (L)(b), \
+        (L)(c), \
+        (L)(d), \
+        (L)(e), \
+        ckd_muladd_signs(a, b, c, d, e), \
+        ckd_muladd_narrow(L, a, b, c, d, e)))
+
+#  ifdef ckd_have_int128
+#    define ckd_muladd2(res, a, b, c, d, e) \
+      (sizeof(*(res)) <= 8 && sizeof(a) <= 8 && sizeof(b) <= 8 \
+               && sizeof(c) <= 8 && sizeof(d) <= 8 && sizeof(e) <= 8 \
+           ? ckd_muladd_expr( \
+                 ckd_muladd64, ckd_uint64, (res), a, b, c, d, e) \
+           : ckd_muladd_expr( \
+                 ckd_muladd, ckd_uintmax, (res), a, b, c, d, e))
+#  else
+#    define ckd_muladd2(res, a, b, c, d, e) \
+      ckd_muladd_expr(ckd_muladd, ckd_uintmax, (res), a, b, c, d, e)
+#  endif
+
+#  define ckd_declare_acc(S, W, L, SL) \
+    ckd_inline L W(L* hi, L x, L y) \
+    { \
+      L m = ((L)1 << (sizeof(L) * 4)) - 1; \
+      L ll, lh, hl, mid; \
+      if (!((x | y) >> (sizeof(L) * 4))) { \
+        *hi = 0; \
+        return x * y; \
+      } \
+      ll = (x & m) * (y & m); \
+      lh = (x & m) * (y >> (sizeof(L) * 4)); \
+      hl = (x >> (sizeof(L) * 4)) * (y & m); \
+      mid = (ll >> (sizeof(L) * 4)) + (lh & m) + (hl & m); \
+      *hi = (x >> (sizeof(L) * 4)) * (y >> (sizeof(L) * 4)) \
+          + (lh >> (sizeof(L) * 4)) + (hl >> (sizeof(L) * 4)) \
+          + (mid >> (sizeof(L) * 4)); \
+      return (mid << (sizeof(L) * 4)) | (ll & m); \
+    } \
+    ckd_inline void S(L* lo, \
+                      L* hi, \
+                      bool* neg, \
+                      bool* o, \
+                      L x, \
+                      L y, \
+                      unsigned char xy_signed) \
+    { \
+      bool n = false; \
+      L h, l, c; \
+      if ((xy_signed & 2) && (SL)x < 0) { \
+        x = -x; \
+        n = !n; \
+      } \
+      if ((xy_signed & 1) && (SL)y < 0) { \
+        y = -y; \
+        n = !n; \
+      } \
+      l = W(&h, x, y); \
+      if (n == *neg) { \
+        *lo += l; \
+        c = *lo < l; \
+        *hi += h; \
+        *o |= *hi < h; \
+        *hi += c; \
+        *o |= *hi < c; \
+      } else if (*hi > h || (*hi == h && *lo >= l)) { \
+        *hi = *hi - h - (L)(*lo < l); \
+        *lo = *lo - l; \
+      } else { \
+        *hi = h - *hi - (L)(l < *lo); \
+        *lo = l - *lo; \
+        *neg = n; \
+      } \
+    }
+
+#  define ckd_declare_muladd(S, T, P, L, SL, ACC) \
+    ckd_inline bool ckd_##P##_##S(void* res, \
+                                  L a, \
+                                  L b, \
+                                  L c, \
+                                  L d, \
+                                  L e, \
+                                  unsigned char signs, \
+                                  bool narrow) \
+    { \
+      L lo = 0; \
+      L hi = 0; \
+      bool neg = false; \
+      bool o = false; \
+      L m = ckd_is_signed((T)0) ? ((L)1 << (sizeof(T) * 8 - 1)) - 1 \
+                                : (L)(T)-1; \
+      if (narrow) { \
+        SL z = (SL)a * (SL)b + (SL)c * (SL)d + (SL)e; \
+        *(T*)res = (T)z; \
+        if (ckd_is_signed((T)0)) { \
+          return (bool)(z != (SL)(*(T*)res)); \
+        } else { \
+          return (bool)((z < 0) | ((L)z > m)); \
+        } \
+      } \
+      if (!signs) { \
+        L p, q, z; \
+        o = ckd_umulo(&p, a, b); \
+        o |= ckd_umulo(&q, c, d); \
+        z = p + q; \
+        o |= z < p; \
+        z += e; \
+        o |= z < e; \
+        *(T*)res = (T)z; \
+        return (bool)(o | (z > m)); \
+      } \
+      ACC(&lo, &hi, &neg, &o, a, b, signs >> 3 & 3); \
+      ACC(&lo, &hi, &neg, &o, c, d, signs >> 1 & 3); \
+      ACC(&lo, &hi, &neg, &o, e, 1, (signs & 1) << 1); \
+      if (neg) { \
+        m = ckd_is_signed((T)0) ? m + 1 : 0; \
+      } \
+      *(T*)res = (T)(neg ? -lo : lo); \
+      return (bool)(o | (hi != 0) | (lo > m)); \
+    }
+
+/* clang-format off */
+ckd_declare_acc(ckd_acc_max, ckd_umul_wide_max, ckd_uintmax, ckd_intmax)
+ckd_each_int(ckd_declare_muladd, muladd, ckd_uintmax, ckd_intmax, ckd_acc_max)
+#  ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_muladd, muladd, ckd_uintmax, ckd_intmax, ckd_acc_max)
+ckd_declare_acc(ckd_acc64, ckd_umul_wide64, ckd_uint64, ckd_int64)
+ckd_each_int(ckd_declare_muladd, muladd64, ckd_uint64, ckd_int64, ckd_acc64)
+#  endif
+/* clang-format on */
+
+#endif
+
+/*
+ * Call sites. In C++ the instrumented modes at the end of this file take
+ * the file and line of the caller through default arguments, so they're
+ * still templates, and arguments like f<int, long>() still work. The
+ * contexts and failure policies take them too, and pass them along.
+ */
+#if defined(ckd_have_templates) \
+    && (defined(JTCKDINT_OPTION_STATS) && JTCKDINT_OPTION_STATS == 1 \
+        || defined(JTCKDINT_OPTION_USDT) && JTCKDINT_OPTION_USDT == 1)
+#  define ckd_have_site
+
+#  define ckd_site_params \
+    , char const* file = __builtin_FILE(), unsigned line = __builtin_LINE()
+#  define ckd_site(op, res, a, b) ckd_site_##op(res, a, b, file, line)
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_add(T* res,
+                                           U a,
+                                           V b ckd_site_params);
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_sub(T* res,
+                                           U a,
+                                           V b ckd_site_params);
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_mul(T* res,
+                                           U a,
+                                           V b ckd_site_params);
+
+#elif defined(ckd_have_templates)
+#  define ckd_site_params
+#  define ckd_site(op, res, a, b) ckd_##op(res, a, b)
+#endif
+
+/*
+ * Sticky contexts. Each operation ORs its flag into the context, which
+ * is then checked once, e.g. after parsing a record. Since nothing but
+ * the flag is stored, the compiler is able to keep it in a register.
+ */
+
+#if defined(ckd_have_templates)
+
+struct ckd_ctx
+{
+  bool failed;
+};
+
+ckd_constexpr ckd_inline void ckd_ctx_init(ckd_ctx* c)
+{
+  c->failed = false;
+}
+
+ckd_constexpr ckd_inline bool ckd_ctx_failed(ckd_ctx const* c)
+{
+  return c->failed;
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_ctx_add(ckd_ctx* c,
+                                           T* res,
+                                           U a,
+                                           V b ckd_site_params)
+{
+  c->failed |= ckd_site(add, res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_ctx_sub(ckd_ctx* c,
+                                           T* res,
+                                           U a,
+                                           V b ckd_site_params)
+{
+  c->failed |= ckd_site(sub, res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_ctx_mul(ckd_ctx* c,
+                                           T* res,
+                                           U a,
+                                           V b ckd_site_params)
+{
+  c->failed |= ckd_site(mul, res, a, b);
+}
+
+template<typename T, typename U, typename V, typename W>
+ckd_constexpr ckd_inline void ckd_ctx_muladd(
+    ckd_ctx* c, T* res, U a, V b, W d)
+{
+  c->failed |= ckd_muladd(res, a, b, d);
+}
+
+#elif defined(ckd_have_generic)
+
+typedef struct ckd_ctx
+{
+  bool failed;
+} ckd_ctx;
+
+#  define ckd_ctx_init(c) ((void)((c)->failed = false))
+#  define ckd_ctx_failed(c) ((bool)(c)->failed)
+
+#  define ckd_ctx_add(c, res, a, b) ((void)((c)->failed |= ckd_add(res, a, b)))
+#  define ckd_ctx_sub(c, res, a, b) ((void)((c)->failed |= ckd_sub(res, a, b)))
+#  define ckd_ctx_mul(c, res, a, b) ((void)((c)->failed |= ckd_mul(res, a, b)))
+#  define ckd_ctx_muladd(c, res, a, b, d) \
+    ((void)((c)->failed |= ckd_muladd(res, a, b, d)))
+
+#endif
+
+/*
+ * Failure policies. Most call sites just abort, or jump to an error path,
+ * so these variants tell the compiler that failure is unlikely. The fast
+ * path then stays straight-line, and the failing branch is laid out at
+ * the end of the function, where it's either a trap, e.g. `jo` to `ud2`
+ * on x86, or a call to a handler. In C++ the handler may be a lambda,
+ * which gets called from a function that's never inlined. C handlers
+ * should be declared ckd_cold for the same effect.
+ */
+
+#if defined(__GNUC__) || defined(__llvm__)
+#  define ckd_unlikely(x) __builtin_expect(!!(x), 0)
+#  define ckd_cold __attribute__((__noinline__, __cold__))
+#  define ckd_trap() __builtin_trap()
+#elif defined(_MSC_VER)
+#  include <intrin.h>
+#  define ckd_unlikely(x) (x)
+#  define ckd_cold __declspec(noinline)
+#  define ckd_trap() __fastfail(7)
+#else
+#  include <stdlib.h>
+#  define ckd_unlikely(x) (x)
+#  define ckd_cold
+#  define ckd_trap() abort()
+#endif
+
+#if defined(ckd_have_templates)
+
+template<typename F>
+ckd_cold void ckd_call_cold(F& handler)
+{
+  handler();
+}
+
+ckd_constexpr ckd_inline void ckd_or_trap(bool failed)
+{
+  if (ckd_unlikely(failed)) {
+    ckd_trap();
+  }
+}
+
+template<typename F>
+ckd_constexpr ckd_inline void ckd_or(bool failed, F handler)
+{
+  if (ckd_unlikely(failed)) {
+    ckd_call_cold(handler);
+  }
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_add_or_trap(T* res,
+                                               U a,
+                                               V b ckd_site_params)
+{
+  ckd_or_trap(ckd_site(add, res, a, b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_sub_or_trap(T* res,
+                                               U a,
+                                               V b ckd_site_params)
+{
+  ckd_or_trap(ckd_site(sub, res, a, b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline void ckd_mul_or_trap(T* res,
+                                               U a,
+                                               V b ckd_site_params)
+{
+  ckd_or_trap(ckd_site(mul, res, a, b));
+}
+
+template<typename T, typename U, typename V, typename F>
+ckd_constexpr ckd_inline void ckd_add_or(T* res,
+                                          U a,
+                                          V b,
+                                          F handler ckd_site_params)
+{
+  ckd_or(ckd_site(add, res, a, b), handler);
+}
+
+template<typename T, typename U, typename V, typename F>
+ckd_constexpr ckd_inline void ckd_sub_or(T* res,
+                                          U a,
+                                          V b,
+                                          F handler ckd_site_params)
+{
+  ckd_or(ckd_site(sub, res, a, b), handler);
+}
+
+template<typename T, typename U, typename V, typename F>
+ckd_constexpr ckd_inline void ckd_mul_or(T* res,
+                                          U a,
+                                          V b,
+                                          F handler ckd_site_params)
+{
+  ckd_or(ckd_site(mul, res, a, b), handler);
+}
+
+#else
+
+#  define ckd_add_or_trap(res, a, b) \
+    ((void)(ckd_unlikely(ckd_add(res, a, b)) ? ckd_trap() : (void)0))
+#  define ckd_sub_or_trap(res, a, b) \
+    ((void)(ckd_unlikely(ckd_sub(res, a, b)) ? ckd_trap() : (void)0))
+#  define ckd_mul_or_trap(res, a, b) \
+    ((void)(ckd_unlikely(ckd_mul(res, a, b)) ? ckd_trap() : (void)0))
+
+#  define ckd_add_or(res, a, b, handler) \
+    ((void)(ckd_unlikely(ckd_add(res, a, b)) && ((handler)(), 1)))
+#  define ckd_sub_or(res, a, b, handler) \
+    ((void)(ckd_unlikely(ckd_sub(res, a, b)) && ((handler)(), 1)))
+#  define ckd_mul_or(res, a, b, handler) \
+    ((void)(ckd_unlikely(ckd_mul(res, a, b)) && ((handler)(), 1)))
+
+#endif
+
+/*
+ * Saturating arithmetic. The exact result is computed the same way as
+ * the checked functions, except when it doesn't fit it gets clamped to
+ * the nearest value of the result type, and true is returned. When the
+ * types are narrow enough for the exact result to fit in a lane, it's
+ * clamped with min / max, which compilers are able to vectorize.
+ */
+
+#if defined(ckd_have_templates)
+
+template<typename T, typename SL>
+ckd_constexpr ckd_inline bool ckd_clamp(T* res, SL z)
+{
+  auto lo = static_cast<SL>((std::numeric_limits<T>::min)());
+  auto hi = static_cast<SL>((std::numeric_limits<T>::max)());
+  bool o = (z < lo) | (z > hi);
+  z = z < lo ? lo : z;
+  z = z > hi ? hi : z;
+  *res = static_cast<T>(z);
+  return o;
+}
+
+template<typename T>
+ckd_constexpr ckd_inline bool ckd_saturate(T* res, T z, bool o, bool neg)
+{
+  *res = o ? (neg ? (std::numeric_limits<T>::min)()
+                  : (std::numeric_limits<T>::max)())
+           : z;
+  return o;
+}
+
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_sat_add(T* res, U a, V b)
+{
+  typedef typename std::make_signed<L>::type SL;
+  if (sizeof(T) < sizeof(L) && sizeof(U) < sizeof(L) && sizeof(V) < sizeof(L)) {
+    return ckd_clamp(
+        res, static_cast<SL>(static_cast<SL>(a) + static_cast<SL>(b)));
+  }
+  auto x = static_cast<L>(a);
+  auto y = static_cast<L>(b);
+  bool xn = std::is_signed<U>::value && static_cast<SL>(x) < 0;
+  bool yn = std::is_signed<V>::value && static_cast<SL>(y) < 0;
+  T z = 0;
+  bool o = ckd_lane_add<L>(&z, a, b);
+  return ckd_saturate(res,
+                      z,
+                      o,
+                      xn == yn ? xn
+                               : (static_cast<SL>(x + y) < 0)
+                                   & (static_cast<SL>(xn ? y : x) >= 0));
+}
+
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_sat_sub(T* res, U a, V b)
+{
+  typedef typename std::make_signed<L>::type SL;
+  if (sizeof(T) < sizeof(L) && sizeof(U) < sizeof(L) && sizeof(V) < sizeof(L)) {
+    return ckd_clamp(
+        res, static_cast<SL>(static_cast<SL>(a) - static_cast<SL>(b)));
+  }
+  auto x = static_cast<L>(a);
+  auto y = static_cast<L>(b);
+  bool xn = std::is_signed<U>::value && static_cast<SL>(x) < 0;
+  bool yn = std::is_signed<V>::value && static_cast<SL>(y) < 0;
+  T z = 0;
+  bool o = ckd_lane_sub<L>(&z, a, b);
+  return ckd_saturate(res, z, o, xn != yn ? xn : x < y);
+}
+
+template<typename L, typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_lane_sat_mul(T* res, U a, V b)
+{
+  typedef typename std::make_signed<L>::type SL;
+  if (sizeof(T) < sizeof(L)
+      && ckd_bits<U>::value + ckd_bits<V>::value
+          <= static_cast<int>(sizeof(L) * 8) - 2)
+  {
+    return ckd_clamp(
+        res, static_cast<SL>(static_cast<SL>(a) * static_cast<SL>(b)));
+  }
+  bool xn = std::is_signed<U>::value && static_cast<SL>(static_cast<L>(a)) < 0;
+  bool yn = std::is_signed<V>::value && static_cast<SL>(static_cast<L>(b)) < 0;
+  T z = 0;
+  bool o = ckd_lane_mul<L>(&z, a, b);
+  return ckd_saturate(res, z, o, xn != yn);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_sat_add(T* res, U a, V b)
+{
+  return ckd_lane_sat_add<typename ckd_lane<T, U, V>::type>(res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_sat_sub(T* res, U a, V b)
+{
+  return ckd_lane_sat_sub<typename ckd_lane<T, U, V>::type>(res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_sat_mul(T* res, U a, V b)
+{
+  return ckd_lane_sat_mul<typename ckd_lane<T, U, V>::type>(res, a, b);
+}
+
+struct ckd_op_sat_add
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_sat_add<L>(res, a, b);
+  }
+};
+
+struct ckd_op_sat_sub
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_sat_sub<L>(res, a, b);
+  }
+};
+
+struct ckd_op_sat_mul
+{
+  template<typename L, typename T, typename U, typename V>
+  static ckd_constexpr ckd_inline bool apply(T* res, U a, V b)
+  {
+    return ckd_lane_sat_mul<L>(res, a, b);
+  }
+};
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_sat_add_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_sat_add>(res, a, b, n);
+}
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_sat_sub_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_sat_sub>(res, a, b, n);
+}
+
+template<typename T, typename U, typename V>
+inline std::size_t ckd_sat_mul_n(T* res, U const* a, V const* b, std::size_t n)
+{
+  return ckd_expr_n<ckd_op_sat_mul>(res, a, b, n);
+}
+
+#  ifdef __cpp_lib_span
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_sat_add_n(std::span<T, N> res,
+                                 std::span<U, M> a,
+                                 std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_sat_add>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_sat_sub_n(std::span<T, N> res,
+                                 std::span<U, M> a,
+                                 std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_sat_sub>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+
+template<typename T,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline std::size_t ckd_sat_mul_n(std::span<T, N> res,
+                                 std::span<U, M> a,
+                                 std::span<V, K> b)
+{
+  return ckd_expr_n<ckd_op_sat_mul>(
+      res.data(),
+      a.data(),
+      b.data(),
+      ckd_span_size(res.size(), a.size(), b.size()));
+}
+#  endif
+
+#elif defined(ckd_have_extras)
+
+#  define ckd_sat_add(res, a, b) ckd_sat_expr(add, (res), (a), (b))
+#  define ckd_sat_sub(res, a, b) ckd_sat_expr(sub, (res), (a), (b))
+#  define ckd_sat_mul(res, a, b) ckd_sat_expr(mul, (res), (a), (b))
+
+#  define ckd_sat_add_n(res, a, b, n) ckd_expr_n(sat_add, (res), (a), (b), (n))
+#  define ckd_sat_sub_n(res, a, b, n) ckd_expr_n(sat_sub, (res), (a), (b), (n))
+#  define ckd_sat_mul_n(res, a, b, n) ckd_expr_n(sat_mul, (res), (a), (b), (n))
+
+#  define ckd_sat_expr(op, res, a, b) \
+    (_Generic(*res, \
+         signed char: ckd_sat_##op##_schar, \
+         unsigned char: ckd_sat_##op##_uchar, \
+         signed short: ckd_sat_##op##_sshort, \
+         unsigned short: ckd_sat_##op##_ushort, \
+         signed int: ckd_sat_##op##_sint, \
+         unsigned int: ckd_sat_##op##_uint, \
+         signed long: ckd_sat_##op##_slong, \
+         unsigned long: ckd_sat_##op##_ulong, \
+         signed long long: ckd_sat_##op##_slonger, \
+         unsigned long long: ckd_sat_##op##_ulonger ckd_generic_int128( \
+             ckd_sat_##op##_sint128, ckd_sat_##op##_uint128))( \
+        res, \
+        (ckd_uintmax)(a), \
+        (ckd_uintmax)(b), \
+        (ckd_is_signed(a) << 1) | ckd_is_signed(b)))
+
+/* whether the exact result is negative, given the operand signs */
+#  define ckd_sat_neg_add(x, y, xn, yn, SL) \
+    ((xn) == (yn) ? (xn) \
+                  : ((SL)((x) + (y)) < 0) & ((SL)((xn) ? (y) : (x)) >= 0))
+#  define ckd_sat_neg_sub(x, y, xn, yn, SL) ((xn) != (yn) ? (xn) : (x) < (y))
+#  define ckd_sat_neg_mul(x, y, xn, yn, SL) ((xn) != (yn))
+
+#  define ckd_declare_sat(S, T, P, L, SL, NEG) \
+    ckd_inline bool ckd_sat_##P##_##S(void* res, \
+                                      L x, \
+                                      L y, \
+                                      unsigned char ab_signed) \
+    { \
+      T z; \
+      T hi = (T)(ckd_is_signed((T)0) ? ((L)1 << (sizeof(T) * 8 - 1)) - 1 \
+                                     : (L)(T)-1); \
+      bool xn = (ab_signed >> 1) && (SL)x < 0; \
+      bool yn = (ab_signed & 1) && (SL)y < 0; \
+      bool o = ckd_##P##_##S(&z, x, y, ab_signed); \
+      bool n = NEG(x, y, xn, yn, SL); \
+      *(T*)res = o ? (n ? (T)~hi : hi) : z; \
+      return o; \
+    }
+
+#  define ckd_declare_sat_n(op, S, T, W, OP) \
+    static inline size_t ckd_sat_##op##_n_##S(T* res, \
+                                              void const* a, \
+                                              unsigned char a_type, \
+                                              void const* b, \
+                                              unsigned char b_type, \
+                                              size_t n) \
+    { \
+      if (a_type == ckd_type_code((T)0) && b_type == a_type) { \
+        T const* p = (T const*)a; \
+        T const* q = (T const*)b; \
+        W hi = ckd_is_signed((T)0) \
+            ? (W)(((unsigned)1 << (sizeof(T) * 8 - 1)) - 1) \
+            : (W)(T)-1; \
+        W lo = ckd_is_signed((T)0) ? -hi - 1 : 0; \
+        unsigned char f[ckd_lanes] = {0}; \
+        size_t i; \
+        size_t k; \
+        size_t m; \
+        size_t first = n; \
+        for (i = 0; i < n; i += m) { \
+          unsigned char o = 0; \
+          m = n - i < ckd_lanes ? n - i : ckd_lanes; \
+          for (k = 0; k != m; ++k) { \
+            W z = (W)p[i + k] OP (W)q[i + k]; \
+            f[k] = (z < lo) | (z > hi); \
+            o |= f[k]; \
+            z = z < lo ? lo : z; \
+            z = z > hi ? hi : z; \
+            res[i + k] = (T)z; \
+          } \
+          if (o && first == n) { \
+            for (k = 0; !f[k]; ++k) { \
+            } \
+            first = i + k; \
+          } \
+        } \
+        return first; \
+      } \
+      if (a_type < 10 && b_type < 10) { \
+        ckd_lanes_n(ckd_uint64, ckd_lane64(sat_##op, S), ckd_load64_n); \
+      } \
+      ckd_lanes_n(ckd_uintmax, ckd_sat_##op##_##S, ckd_load_n); \
+    }
+
+/* clang-format off */
+ckd_each_int(ckd_declare_sat, add, ckd_uintmax, ckd_intmax, ckd_sat_neg_add)
+ckd_each_int(ckd_declare_sat, sub, ckd_uintmax, ckd_intmax, ckd_sat_neg_sub)
+ckd_each_int(ckd_declare_sat, mul, ckd_uintmax, ckd_intmax, ckd_sat_neg_mul)
+#  ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_sat, add, ckd_uintmax, ckd_intmax, ckd_sat_neg_add)
+ckd_each_int(ckd_declare_sat, add64, ckd_uint64, ckd_int64, ckd_sat_neg_add)
+ckd_each_int128(ckd_declare_sat, sub, ckd_uintmax, ckd_intmax, ckd_sat_neg_sub)
+ckd_each_int(ckd_declare_sat, sub64, ckd_uint64, ckd_int64, ckd_sat_neg_sub)
+ckd_each_int128(ckd_declare_sat, mul, ckd_uintmax, ckd_intmax, ckd_sat_neg_mul)
+ckd_each_int(ckd_declare_sat, mul64, ckd_uint64, ckd_int64, ckd_sat_neg_mul)
+#  endif
+/* clang-format on */
+
+ckd_declare_sat_n(add, schar, signed char, int, +)
+ckd_declare_sat_n(add, uchar, unsigned char, int, +)
+ckd_declare_sat_n(add, sshort, signed short, int, +)
+ckd_declare_sat_n(add, ushort, unsigned short, int, +)
+ckd_declare_n(sat_add, sint, signed int)
+ckd_declare_n(sat_add, uint, unsigned int)
+ckd_declare_n(sat_add, slong, signed long)
+ckd_declare_n(sat_add, ulong, unsigned long)
+ckd_declare_n(sat_add, slonger, signed long long)
+ckd_declare_n(sat_add, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(sat_add, sint128, signed __int128)
+ckd_declare_n128(sat_add, uint128, unsigned __int128)
+#  endif
+
+ckd_declare_sat_n(sub, schar, signed char, int, -)
+ckd_declare_sat_n(sub, uchar, unsigned char, int, -)
+ckd_declare_sat_n(sub, sshort, signed short, int, -)
+ckd_declare_sat_n(sub, ushort, unsigned short, int, -)
+ckd_declare_n(sat_sub, sint, signed int)
+ckd_declare_n(sat_sub, uint, unsigned int)
+ckd_declare_n(sat_sub, slong, signed long)
+ckd_declare_n(sat_sub, ulong, unsigned long)
+ckd_declare_n(sat_sub, slonger, signed long long)
+ckd_declare_n(sat_sub, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(sat_sub, sint128, signed __int128)
+ckd_declare_n128(sat_sub, uint128, unsigned __int128)
+#  endif
+
+ckd_declare_sat_n(mul, schar, signed char, int, *)
+ckd_declare_sat_n(mul, uchar, unsigned char, int, *)
+ckd_declare_sat_n(mul, sshort, signed short, int, *)
+ckd_declare_sat_n(mul, ushort, unsigned short, ckd_int64, *)
+ckd_declare_n(sat_mul, sint, signed int)
+ckd_declare_n(sat_mul, uint, unsigned int)
+ckd_declare_n(sat_mul, slong, signed long)
+ckd_declare_n(sat_mul, ulong, unsigned long)
+ckd_declare_n(sat_mul, slonger, signed long long)
+ckd_declare_n(sat_mul, ulonger, unsigned long long)
+#  ifdef ckd_have_int128
+ckd_declare_n128(sat_mul, sint128, signed __int128)
+ckd_declare_n128(sat_mul, uint128, unsigned __int128)
+#  endif
+
+#endif
+
+/*
+ * Multi-precision arithmetic. Big unsigned integers are arrays of limbs,
+ * least significant first, whose type may be unsigned int, long or long
+ * long, and whose lengths may all differ. The carry is passed from limb
+ * to limb as a flag, which becomes an `adc` / `sbb` chain when compiler
+ * has a builtin for it. Exact limbs past the end of the result are only
+ * computed to be checked for zero, so a true return value means the low
+ * limbs were stored and the rest were lost, or the difference was less
+ * than zero, in which case it's stored as two's complement. The add and
+ * sub functions allow the result to alias either operand.
+ */
+
+#if defined(_MSC_VER) && !defined(__llvm__) && defined(_M_X64)
+#  include <intrin.h>
+#  define ckd_have_umul128
+#endif
+
+#if defined(ckd_have_templates) || defined(ckd_have_generic)
+
+ckd_inline bool ckd_addc64(unsigned long long* res,
+                           unsigned long long a,
+                           unsigned long long b,
+                           bool carry)
+{
+#  if ckd_has_builtin(__builtin_addcll)
+  unsigned long long c = 0;
+  *res = __builtin_addcll(a, b, carry, &c);
+  return c;
+#  elif ckd_has_builtin(__builtin_ia32_addcarryx_u64)
+  return __builtin_ia32_addcarryx_u64(carry, a, b, res);
+#  elif defined(ckd_have_umul128)
+  return _addcarry_u64(carry, a, b, res);
+#  else
+  unsigned long long z = a + b;
+  bool c = z < a;
+  *res = z + carry;
+  return c | (*res < z);
+#  endif
+}
+
+ckd_inline bool ckd_subb64(unsigned long long* res,
+                           unsigned long long a,
+                           unsigned long long b,
+                           bool borrow)
+{
+#  if ckd_has_builtin(__builtin_subcll)
+  unsigned long long c = 0;
+  *res = __builtin_subcll(a, b, borrow, &c);
+  return c;
+#  elif ckd_has_builtin(__builtin_ia32_sbb_u64)
+  return __builtin_ia32_sbb_u64(borrow, a, b, res);
+#  elif defined(ckd_have_umul128)
+  return _subborrow_u64(borrow, a, b, res);
+#  else
+  unsigned long long z = a - b;
+  bool c = a < b;
+  *res = z - borrow;
+  return c | (z < *res);
+#  endif
+}
+
+#endif
+
+#if defined(ckd_have_templates)
+
+// Validates the limb type, and keeps it from being deduced from more
+// than one argument, so ckd_addc(&ul, 1, 2, 0) means unsigned long.
+template<typename L>
+struct ckd_limb_type
+{
+  static_assert(std::is_unsigned<L>::value && !std::is_same<L, bool>::value
+                    && sizeof(L) >= sizeof(unsigned)
+                    && sizeof(L) <= sizeof(unsigned long long),
+                "limbs must be unsigned int, long or long long");
+  typedef L type;
+};
+
+// Returns the low half of a * b + c + d, which can't overflow 128 bits.
+ckd_inline unsigned long long ckd_mac64(unsigned long long* hi,
+                                        unsigned long long a,
+                                        unsigned long long b,
+                                        unsigned long long c,
+                                        unsigned long long d)
+{
+#  ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 W;
+  W p = static_cast<W>(a) * b + c + d;
+  *hi = static_cast<unsigned long long>(p >> 64);
+  return static_cast<unsigned long long>(p);
+#  else
+  unsigned long long h = 0;
+#    ifdef ckd_have_umul128
+  unsigned long long l = _umul128(a, b, &h);
+#    else
+  unsigned long long l = ckd_umul_wide(&h, a, b);
+#    endif
+  h += ckd_addc64(&l, l, c, false);
+  h += ckd_addc64(&l, l, d, false);
+  *hi = h;
+  return l;
+#  endif
+}
+
+template<typename L>
+ckd_inline bool ckd_addc(L* res,
+                         typename ckd_limb_type<L>::type a,
+                         typename ckd_limb_type<L>::type b,
+                         bool carry)
+{
+  if (sizeof(L) == sizeof(unsigned long long)) {
+    unsigned long long z = 0;
+    bool c = ckd_addc64(&z, a, b, carry);
+    *res = static_cast<L>(z);
+    return c;
+  }
+  auto z = static_cast<L>(a + b);
+  bool c = z < a;
+  *res = static_cast<L>(z + carry);
+  return c | (*res < z);
+}
+
+template<typename L>
+ckd_inline bool ckd_subb(L* res,
+                         typename ckd_limb_type<L>::type a,
+                         typename ckd_limb_type<L>::type b,
+                         bool borrow)
+{
+  if (sizeof(L) == sizeof(unsigned long long)) {
+    unsigned long long z = 0;
+    bool c = ckd_subb64(&z, a, b, borrow);
+    *res = static_cast<L>(z);
+    return c;
+  }
+  auto z = static_cast<L>(a - b);
+  bool c = a < b;
+  *res = static_cast<L>(z - borrow);
+  return c | (z < *res);
+}
+
+template<typename L>
+ckd_inline L ckd_mac(L* hi, L a, L b, L c, L d)
+{
+  if (sizeof(L) < sizeof(unsigned long long)) {
+    auto p = static_cast<unsigned long long>(a) * b + c + d;
+    *hi = static_cast<L>(p >> (sizeof(L) * 4) >> (sizeof(L) * 4));
+    return static_cast<L>(p);
+  }
+  unsigned long long h = 0;
+  unsigned long long l = ckd_mac64(&h, a, b, c, d);
+  *hi = static_cast<L>(h);
+  return static_cast<L>(l);
+}
+
+template<typename L>
+inline bool ckd_add_limbs(L* z,
+                          std::size_t zn,
+                          L const* x,
+                          std::size_t xn,
+                          L const* y,
+                          std::size_t yn)
+{
+  std::size_t i = 0;
+  bool c = false;
+  bool o = false;
+  for (; i < xn && i < yn && i < zn; ++i) {
+    c = ckd_addc(z + i, x[i], y[i], c);
+  }
+  for (; i < xn || i < yn; ++i) {
+    L t = 0;
+    c = ckd_addc(&t, i < xn ? x[i] : 0, i < yn ? y[i] : 0, c);
+    if (i < zn) {
+      z[i] = t;
+    } else {
+      o |= !!t;
+    }
+  }
+  for (; i < zn; ++i) {
+    z[i] = c;
+    c = false;
+  }
+  return o | c;
+}
+
+template<typename L>
+inline bool ckd_sub_limbs(L* z,
+                          std::size_t zn,
+                          L const* x,
+                          std::size_t xn,
+                          L const* y,
+                          std::size_t yn)
+{
+  std::size_t i = 0;
+  bool b = false;
+  bool o = false;
+  for (; i < xn && i < yn && i < zn; ++i) {
+    b = ckd_subb(z + i, x[i], y[i], b);
+  }
+  for (; i < xn || i < yn; ++i) {
+    L t = 0;
+    b = ckd_subb(&t, i < xn ? x[i] : 0, i < yn ? y[i] : 0, b);
+    if (i < zn) {
+      z[i] = t;
+    } else {
+      o |= !!t;
+    }
+  }
+  for (; i < zn; ++i) {
+    z[i] = static_cast<L>(0 - static_cast<L>(b));
+  }
+  return o | b;
+}
+
+// Schoolbook multiplication, where z must not overlap x or y. Each row
+// stops at the end of z, after which it only checks what remains.
+template<typename L>
+inline bool ckd_mul_limbs(L* z,
+                          std::size_t zn,
+                          L const* x,
+                          std::size_t xn,
+                          L const* y,
+                          std::size_t yn)
+{
+  bool o = false;
+  for (std::size_t k = 0; k != zn; ++k) {
+    z[k] = 0;
+  }
+  for (std::size_t i = 0; i != xn; ++i) {
+    if (!x[i]) {
+      continue;
+    }
+    std::size_t j = 0;
+    std::size_t m = i < zn ? zn - i : 0;
+    L c = 0;
+    for (; j < yn && j < m; ++j) {
+      z[i + j] = ckd_mac(&c, x[i], y[j], z[i + j], c);
+    }
+    if (j < m) {
+      z[i + j] = c;
+    } else {
+      o |= !!c;
+      for (; j < yn; ++j) {
+        o |= !!y[j];
+      }
+    }
+  }
+  return o;
+}
+
+#  ifdef __cpp_lib_span
+template<typename L,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline bool ckd_add_limbs(std::span<L, N> z,
+                          std::span<U, M> x,
+                          std::span<V, K> y)
+{
+  return ckd_add_limbs(
+      z.data(), z.size(), x.data(), x.size(), y.data(), y.size());
+}
+
+template<typename L,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline bool ckd_sub_limbs(std::span<L, N> z,
+                          std::span<U, M> x,
+                          std::span<V, K> y)
+{
+  return ckd_sub_limbs(
+      z.data(), z.size(), x.data(), x.size(), y.data(), y.size());
+}
+
+template<typename L,
+         std::size_t N,
+         typename U,
+         std::size_t M,
+         typename V,
+         std::size_t K>
+inline bool ckd_mul_limbs(std::span<L, N> z,
+                          std::span<U, M> x,
+                          std::span<V, K> y)
+{
+  return ckd_mul_limbs(
+      z.data(), z.size(), x.data(), x.size(), y.data(), y.size());
+}
+#  endif
+
+#elif defined(ckd_have_generic)
+
+/* returns the low half of a * b + c + d, which can't overflow 128 bits */
+ckd_inline ckd_uint64 ckd_mac64(
+    ckd_uint64* hi, ckd_uint64 a, ckd_uint64 b, ckd_uint64 c, ckd_uint64 d)
+{
+#  ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 W;
+  W p = (W)a * b + c + d;
+  *hi = (ckd_uint64)(p >> 64);
+  return (ckd_uint64)p;
+#  else
+  ckd_uint64 h = 0;
+  ckd_uint64 l = 0;
+#    ifdef ckd_have_umul128
+  l = _umul128(a, b, &h);
+#    else
+  ckd_uint64 m = 0xffffffff;
+  ckd_uint64 ll = (a & m) * (b & m);
+  ckd_uint64 lh = (a & m) * (b >> 32);
+  ckd_uint64 hl = (a >> 32) * (b & m);
+  ckd_uint64 mid = (ll >> 32) + (lh & m) + (hl & m);
+  h = (a >> 32) * (b >> 32) + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  l = mid << 32 | (ll & m);
+#    endif
+  h += ckd_addc64(&l, l, c, false);
+  h += ckd_addc64(&l, l, d, false);
+  *hi = h;
+  return l;
+#  endif
+}
+
+#  define ckd_limb_expr(op, z, ...) \
+    (_Generic(*(z), \
+         unsigned int: ckd_##op##_uint, \
+         unsigned long: ckd_##op##_ulong, \
+         unsigned long long: ckd_##op##_ulonger)(z, __VA_ARGS__))
+
+#  define ckd_addc(res, a, b, carry) ckd_limb_expr(addc, res, a, b, carry)
+#  define ckd_subb(res, a, b, borrow) ckd_limb_expr(subb, res, a, b, borrow)
+#  define ckd_add_limbs(z, zn, x, xn, y, yn) \
+    ckd_limb_expr(add_limbs, z, zn, x, xn, y, yn)
+#  define ckd_sub_limbs(z, zn, x, xn, y, yn) \
+    ckd_limb_expr(sub_limbs, z, zn, x, xn, y, yn)
+#  define ckd_mul_limbs(z, zn, x, xn, y, yn) \
+    ckd_limb_expr(mul_limbs, z, zn, x, xn, y, yn)
+
+#  define ckd_declare_bignum(S, L) \
+    ckd_inline bool ckd_addc_##S(L* res, L a, L b, bool carry) \
+    { \
+      ckd_uint64 z = 0; \
+      bool c; \
+      if (sizeof(L) == sizeof(ckd_uint64)) { \
+        c = ckd_addc64(&z, a, b, carry); \
+        *res = (L)z; \
+        return c; \
+      } \
+      z = (L)(a + b); \
+      c = z < a; \
+      *res = (L)(z + carry); \
+      return c | (*res < z); \
+    } \
+    ckd_inline bool ckd_subb_##S(L* res, L a, L b, bool borrow) \
+    { \
+      ckd_uint64 z = 0; \
+      bool c; \
+      if (sizeof(L) == sizeof(ckd_uint64)) { \
+        c = ckd_subb64(&z, a, b, borrow); \
+        *res = (L)z; \
+        return c; \
+      } \
+      z = (L)(a - b); \
+      c = a < b; \
+      *res = (L)(z - borrow); \
+      return c | (z < *res); \
+    } \
+    ckd_inline L ckd_mac_##S(L* hi, L a, L b, L c, L d) \
+    { \
+      ckd_uint64 h = 0; \
+      ckd_uint64 l; \
+      if (sizeof(L) < sizeof(ckd_uint64)) { \
+        l = (ckd_uint64)a * b + c + d; \
+        *hi = (L)(l >> (sizeof(L) * 4) >> (sizeof(L) * 4)); \
+        return (L)l; \
+      } \
+      l = ckd_mac64(&h, a, b, c, d); \
+      *hi = (L)h; \
+      return (L)l; \
+    } \
+    static inline bool ckd_add_limbs_##S(L* z, \
+                                         size_t zn, \
+                                         L const* x, \
+                                         size_t xn, \
+                                         L const* y, \
+                                         size_t yn) \
+    { \
+      size_t i = 0; \
+      bool c = false; \
+      bool o = false; \
+      L t; \
+      for (; i < xn && i < yn && i < zn; ++i) { \
+        c = ckd_addc_##S(z + i, x[i], y[i], c); \
+      } \
+      for (; i < xn || i < yn; ++i) { \
+        c = ckd_addc_##S(&t, i < xn ? x[i] : 0, i < yn ? y[i] : 0, c); \
+        if (i < zn) { \
+          z[i] = t; \
+        } else { \
+          o |= !!t; \
+        } \
+      } \
+      for (; i < zn; ++i) { \
+        z[i] = c; \
+        c = false; \
+      } \
+      return o | c; \
+    } \
+    static inline bool ckd_sub_limbs_##S(L* z, \
+                                         size_t zn, \
+                                         L const* x, \
+                                         size_t xn, \
+                                         L const* y, \
+                                         size_t yn) \
+    { \
+      size_t i = 0; \
+      bool b = false; \
+      bool o = false; \
+      L t; \
+      for (; i < xn && i < yn && i < zn; ++i) { \
+        b = ckd_subb_##S(z + i, x[i], y[i], b); \
+      } \
+      for (; i < xn || i < yn; ++i) { \
+        b = ckd_subb_##S(&t, i < xn ? x[i] : 0, i < yn ? y[i] : 0, b); \
+        if (i < zn) { \
+          z[i] = t; \
+        } else { \
+          o |= !!t; \
+        } \
+      } \
+      for (; i < zn; ++i) { \
+        z[i] = (L)0 - b; \
+      } \
+      return o | b; \
+    } \
+    static inline bool ckd_mul_limbs_##S(L* z, \
+                                         size_t zn, \
+                                         L const* x, \
+                                         size_t xn, \
+                                         L const* y, \
+                                         size_t yn) \
+    { \
+      bool o = false; \
+      size_t i, j, m; \
+      L c; \
+      for (i = 0; i != zn; ++i) { \
+        z[i] = 0; \
+      } \
+      for (i = 0; i != xn; ++i) { \
+        if (!x[i]) { \
+          continue; \
+        } \
+        m = i < zn ? zn - i : 0; \
+        c = 0; \
+        for (j = 0; j < yn && j < m; ++j) { \
+          z[i + j] = ckd_mac_##S(&c, x[i], y[j], z[i + j], c); \
+        } \
+        if (j < m) { \
+          z[i + j] = c; \
+        } else { \
+          o |= !!c; \
+          for (; j < yn; ++j) { \
+            o |= !!y[j]; \
+          } \
+        } \
+      } \
+      return o; \
+    }
+
+ckd_declare_bignum(uint, unsigned int)
+ckd_declare_bignum(ulong, unsigned long)
+ckd_declare_bignum(ulonger, unsigned long long)
+
+#endif
+
+/*
+ * Checked expressions. In C++ a statement like `z = a * b + c` may be
+ * written with ckd_checked<T> operands, whose operators don't compute
+ * anything, but instead return a tree of the operations. When the tree
+ * is assigned to a ckd_checked<T>, each node is evaluated in the first
+ * lane that's able to hold every value it could have, given the bounds
+ * of its operands, so it can't overflow and needn't be checked. Then a
+ * single check happens when the result gets stored. Only nodes that may
+ * exceed ckd_intmax are computed using ckd_add() etc. which is the same
+ * as what C23 says, unless those intermediate results are too big for
+ * ckd_intmax, in which case the statement is considered to overflow.
+ *
+ *     ckd_checked<int32_t> a = INT32_MAX, b = 2, c = -INT32_MAX;
+ *     ckd_checked<int32_t> z = a * b + c;
+ *     assert(!z.failed && z.value == INT32_MAX);
+ *
+ * The failed flag is sticky, so if an operand has failed, so will the
+ * result of any expression it's used in.
+ *
+ * Operands may also be ckd_bounded<T, Lo, Hi> which is a T that's known
+ * to be within [Lo, Hi] so its bounds are narrower than those of T. The
+ * bounds of each node are computed exactly, from those of its operands,
+ * so ckd_set(&z, e) only generates a check if the bounds of e won't fit
+ * in z. It's not called ckd_add(&z, e) because that may be a builtin.
+ *
+ *     ckd_bounded<int, 0, 255> k = u8;
+ *     ckd_bounded<int, 1, 64> n = ckd_constant<int, 64>();
+ *     ckd_set(&u16, n * k + 1);  // no check, since this is [1, 16321]
+ */
+
+#if defined(ckd_have_templates)
+
+struct ckd_node
+{};
+
+template<typename L>
+struct ckd_value
+{
+  L value;
+  bool failed;
+};
+
+// Bounds are compile time integers in sign-magnitude form, so they can
+// be anything ckd_intmax or ckd_uintmax can be. When a bound overflows
+// that, its magnitude saturates at the maximum and it isn't known.
+template<bool Neg, ckd_uintmax Mag, bool Known = true>
+struct ckd_num
+{
+  static const bool neg = Neg && Mag;
+  static const ckd_uintmax mag = Mag;
+  static const bool known = Known;
+};
+
+template<typename T, T X>
+struct ckd_num_of
+    : ckd_num<(X < static_cast<T>(1) && X != static_cast<T>(0)),
+              (X < static_cast<T>(1) && X != static_cast<T>(0)
+                   ? 0 - static_cast<ckd_uintmax>(X)
+                   : static_cast<ckd_uintmax>(X))>
+{};
+
+template<typename L>
+struct ckd_num_min
+    : ckd_num_of<L, std::numeric_limits<L>::min()>
+{};
+
+template<typename L>
+struct ckd_num_max
+    : ckd_num_of<L, std::numeric_limits<L>::max()>
+{};
+
+template<typename X>
+struct ckd_num_neg : ckd_num<!X::neg, X::mag, X::known>
+{};
+
+template<typename X, typename Y>
+struct ckd_num_add
+    : ckd_num<(X::neg == Y::neg || X::mag >= Y::mag ? X::neg : Y::neg),
+              (X::neg == Y::neg
+                   ? (X::mag > ~Y::mag ? ~static_cast<ckd_uintmax>(0)
+                                       : X::mag + Y::mag)
+                   : !X::known || !Y::known ? ~static_cast<ckd_uintmax>(0)
+                   : X::mag >= Y::mag       ? X::mag - Y::mag
+                                            : Y::mag - X::mag),
+              (X::known && Y::known
+               && (X::neg != Y::neg || X::mag <= ~Y::mag))>
+{};
+
+template<typename X, typename Y>
+struct ckd_num_mul
+    : ckd_num<X::neg != Y::neg,
+              (X::mag && Y::mag > ~static_cast<ckd_uintmax>(0) / X::mag
+                   ? ~static_cast<ckd_uintmax>(0)
+                   : X::mag * Y::mag),
+              (!X::mag || !Y::mag
+               || (X::known && Y::known
+                   && Y::mag <= ~static_cast<ckd_uintmax>(0) / X::mag))>
+{};
+
+template<typename X, typename Y>
+struct ckd_num_less
+    : std::integral_constant<bool,
+                             (X::neg != Y::neg ? X::neg
+                              : X::neg         ? X::mag > Y::mag
+                                               : X::mag < Y::mag)>
+{};
+
+template<typename X, typename Y>
+struct ckd_num_min2
+    : std::conditional<ckd_num_less<Y, X>::value, Y, X>::type
+{};
+
+template<typename X, typename Y>
+struct ckd_num_max2
+    : std::conditional<ckd_num_less<X, Y>::value, Y, X>::type
+{};
+
+// Whether [Lo, Hi] is inside [Min, Max].
+template<typename Lo, typename Hi, typename Min, typename Max>
+struct ckd_num_within
+    : std::integral_constant<bool,
+                             Lo::known && Hi::known
+                                 && !ckd_num_less<Lo, Min>::value
+                                 && !ckd_num_less<Max, Hi>::value>
+{};
+
+template<typename L, typename Lo, typename Hi>
+struct ckd_bound_fits
+    : ckd_num_within<Lo, Hi, ckd_num_min<L>, ckd_num_max<L>>
+{};
+
+// Nodes use the first lane which is able to hold all of their values,
+// otherwise they're checked, and all values of the lane are possible.
+template<typename Lo, typename Hi>
+struct ckd_range
+{
+  typedef typename std::conditional<
+      ckd_bound_fits<long long, Lo, Hi>::value,
+      long long,
+      typename std::conditional<
+          ckd_bound_fits<unsigned long long, Lo, Hi>::value,
+          unsigned long long,
+          typename std::conditional<
+              Lo::neg || ckd_bound_fits<ckd_intmax, Lo, Hi>::value,
+              ckd_intmax,
+              ckd_uintmax>::type>::type>::type lane;
+  static const bool exact = ckd_bound_fits<lane, Lo, Hi>::value;
+  typedef typename std::conditional<exact, Lo, ckd_num_min<lane>>::type lo;
+  typedef typename std::conditional<exact, Hi, ckd_num_max<lane>>::type hi;
+};
+
+template<typename T, T Lo, T Hi>
+struct ckd_bounded;
+
+template<typename X, typename = void>
+struct ckd_node_of
+{};
+
+template<typename X>
+struct ckd_node_of<
+    X,
+    typename std::enable_if<std::is_integral<X>::value>::type>
+{
+  typedef ckd_bounded<X,
+                      std::numeric_limits<X>::min(),
+                      std::numeric_limits<X>::max()>
+      type;
+};
+
+template<typename X>
+struct ckd_node_of<
+    X,
+    typename std::enable_if<std::is_base_of<ckd_node, X>::value>::type>
+{
+  typedef X type;
+};
+
+struct ckd_node_add
+{
+  template<typename A, typename B>
+  struct range
+      : ckd_range<ckd_num_add<typename A::lo, typename B::lo>,
+                  ckd_num_add<typename A::hi, typename B::hi>>
+  {};
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::true_type, bool*, U a, V b)
+  {
+    return static_cast<L>(a) + static_cast<L>(b);
+  }
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::false_type,
+                                          bool* o,
+                                          U a,
+                                          V b)
+  {
+    L z = 0;
+    *o |= ckd_add(&z, a, b);
+    return z;
+  }
+};
+
+struct ckd_node_sub
+{
+  template<typename A, typename B>
+  struct range
+      : ckd_range<ckd_num_add<typename A::lo, ckd_num_neg<typename B::hi>>,
+                  ckd_num_add<typename A::hi, ckd_num_neg<typename B::lo>>>
+  {};
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::true_type, bool*, U a, V b)
+  {
+    return static_cast<L>(a) - static_cast<L>(b);
+  }
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::false_type,
+                                          bool* o,
+                                          U a,
+                                          V b)
+  {
+    L z = 0;
+    *o |= ckd_sub(&z, a, b);
+    return z;
+  }
+};
+
+// The bounds of a product are the least and greatest products of the
+// bounds of its operands.
+struct ckd_node_mul
+{
+  template<typename A, typename B>
+  struct range
+      : ckd_range<
+            ckd_num_min2<
+                ckd_num_min2<ckd_num_mul<typename A::lo, typename B::lo>,
+                             ckd_num_mul<typename A::lo, typename B::hi>>,
+                ckd_num_min2<ckd_num_mul<typename A::hi, typename B::lo>,
+                             ckd_num_mul<typename A::hi, typename B::hi>>>,
+            ckd_num_max2<
+                ckd_num_max2<ckd_num_mul<typename A::lo, typename B::lo>,
+                             ckd_num_mul<typename A::lo, typename B::hi>>,
+                ckd_num_max2<ckd_num_mul<typename A::hi, typename B::lo>,
+                             ckd_num_mul<typename A::hi, typename B::hi>>>>
+  {};
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::true_type, bool*, U a, V b)
+  {
+    return static_cast<L>(a) * static_cast<L>(b);
+  }
+
+  template<typename L, typename U, typename V>
+  static ckd_constexpr ckd_inline L apply(std::false_type,
+                                          bool* o,
+                                          U a,
+                                          V b)
+  {
+    L z = 0;
+    *o |= ckd_mul(&z, a, b);
+    return z;
+  }
+};
+
+// Operands are held by value, so trees may outlive their temporaries.
+template<typename F, typename A, typename B>
+struct ckd_tree : ckd_node
+{
+  typedef typename F::template range<A, B> range;
+  typedef typename range::lane lane;
+  typedef typename range::lo lo;
+  typedef typename range::hi hi;
+  static const bool exact = range::exact && A::exact && B::exact;
+
+  A a;
+  B b;
+
+  ckd_constexpr ckd_tree(A x, B y)
+      : a(x)
+      , b(y)
+  {
+  }
+
+  ckd_constexpr ckd_value<lane> eval() const
+  {
+    auto x = a.eval();
+    auto y = b.eval();
+    bool o = x.failed | y.failed;
+    lane z = F::template apply<lane>(
+        std::integral_constant<bool, range::exact>(), &o, x.value, y.value);
+    return {z, o};
+  }
+};
+
+template<typename T>
+struct ckd_checked : ckd_node
+{
+  static_assert(std::is_integral<T>::value, "non-integral types not allowed");
+  static_assert(!std::is_same<T, bool>::value,
+                "checked booleans not supported");
+  static_assert(!std::is_same<T, char>::value,
+                "unqualified char type is ambiguous");
+
+  typedef T lane;
+  typedef ckd_num_min<T> lo;
+  typedef ckd_num_max<T> hi;
+  static const bool exact = false;
+
+  T value;
+  bool failed;
+
+  ckd_constexpr ckd_checked()
+      : value()
+      , failed(false)
+  {
+  }
+
+  ckd_constexpr ckd_checked(T x)
+      : value(x)
+      , failed(false)
+  {
+  }
+
+  template<typename E,
+           typename = typename ckd_node_of<E>::type,
+           typename = typename std::enable_if<!std::is_same<E, T>::value>::type>
+  ckd_constexpr ckd_checked(E const& e)
+      : value()
+      , failed(false)
+  {
+    store(typename ckd_node_of<E>::type(e));
+  }
+
+  ckd_constexpr ckd_value<T> eval() const
+  {
+    return {value, failed};
+  }
+
+  template<typename E>
+  ckd_constexpr ckd_checked& operator+=(E const& e)
+  {
+    return *this = *this + e;
+  }
+
+  template<typename E>
+  ckd_constexpr ckd_checked& operator-=(E const& e)
+  {
+    return *this = *this - e;
+  }
+
+  template<typename E>
+  ckd_constexpr ckd_checked& operator*=(E const& e)
+  {
+    return *this = *this * e;
+  }
+
+private:
+  template<typename E>
+  ckd_constexpr void store(E const& e)
+  {
+    auto r = e.eval();
+    failed = r.failed;
+    store(ckd_bound_fits<T, typename E::lo, typename E::hi>(), r.value);
+  }
+
+  template<typename L>
+  ckd_constexpr void store(std::true_type, L x)
+  {
+    value = static_cast<T>(x);
+  }
+
+  template<typename L>
+  ckd_constexpr void store(std::false_type, L x)
+  {
+    failed |= ckd_add(&value, x, 0);
+  }
+};
+
+// A value may become a ckd_bounded without a check if it's an integer
+// type or an expression that can't fail, whose bounds are within range.
+template<typename E, typename Lo, typename Hi, typename = void>
+struct ckd_bounds_within : std::false_type
+{};
+
+template<typename E, typename Lo, typename Hi>
+struct ckd_bounds_within<
+    E,
+    Lo,
+    Hi,
+    typename std::enable_if<std::is_integral<E>::value>::type>
+    : ckd_num_within<ckd_num_min<E>, ckd_num_max<E>, Lo, Hi>
+{};
+
+template<typename E, typename Lo, typename Hi>
+struct ckd_bounds_within<
+    E,
+    Lo,
+    Hi,
+    typename std::enable_if<std::is_base_of<ckd_node, E>::value
+                            && E::exact>::type>
+    : ckd_num_within<typename E::lo, typename E::hi, Lo, Hi>
+{};
+
+template<typename E>
+ckd_constexpr ckd_inline
+    typename std::enable_if<std::is_integral<E>::value, E>::type
+    ckd_bounds_value(E x)
+{
+  return x;
+}
+
+template<typename E>
+ckd_constexpr ckd_inline typename E::lane ckd_bounds_value(E const& e)
+{
+  return e.eval().value;
+}
+
+template<typename T, T Lo, T Hi>
+struct ckd_bounded : ckd_node
+{
+  static_assert(std::is_integral<T>::value, "non-integral types not allowed");
+  static_assert(!std::is_same<T, bool>::value,
+                "bounded booleans not supported");
+  static_assert(!std::is_same<T, char>::value,
+                "unqualified char type is ambiguous");
+  static_assert(!(Hi < Lo), "bounds are reversed");
+
+  typedef T lane;
+  typedef ckd_num_of<T, Lo> lo;
+  typedef ckd_num_of<T, Hi> hi;
+  static const bool exact = true;
+
+  T value;
+
+  ckd_constexpr ckd_bounded()
+      : value(Lo)
+  {
+  }
+
+  template<typename E,
+           typename = typename std::enable_if<
+               ckd_bounds_within<E, lo, hi>::value>::type>
+  ckd_constexpr ckd_bounded(E const& e)
+      : value(static_cast<T>(ckd_bounds_value(e)))
+  {
+  }
+
+  ckd_constexpr ckd_value<T> eval() const
+  {
+    return {value, false};
+  }
+};
+
+template<typename T, T N>
+using ckd_constant = ckd_bounded<T, N, N>;
+
+template<typename T, T Lo, T Hi, typename L>
+ckd_constexpr ckd_inline bool
+ckd_set_value(std::true_type, ckd_bounded<T, Lo, Hi>* res, L x)
+{
+  res->value = static_cast<T>(x);
+  return false;
+}
+
+template<typename T, T Lo, T Hi, typename L>
+ckd_constexpr ckd_inline bool
+ckd_set_value(std::false_type, ckd_bounded<T, Lo, Hi>* res, L x)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  T y = T();
+  if (ckd_add(&y, x, 0)
+      || static_cast<U>(static_cast<U>(y) - static_cast<U>(Lo))
+             > static_cast<U>(static_cast<U>(Hi) - static_cast<U>(Lo))) {
+    return true;
+  }
+  res->value = y;
+  return false;
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_set_value(std::true_type, T* res, L x)
+{
+  *res = static_cast<T>(x);
+  return false;
+}
+
+template<typename T, typename L>
+ckd_constexpr ckd_inline bool ckd_set_value(std::false_type, T* res, L x)
+{
+  return ckd_add(res, x, 0);
+}
+
+template<typename T>
+struct ckd_bounds_of
+{
+  typedef ckd_num_min<T> lo;
+  typedef ckd_num_max<T> hi;
+};
+
+template<typename T, T Lo, T Hi>
+struct ckd_bounds_of<ckd_bounded<T, Lo, Hi>>
+{
+  typedef ckd_num_of<T, Lo> lo;
+  typedef ckd_num_of<T, Hi> hi;
+};
+
+// Stores an expression into an integer or ckd_bounded, returning true if
+// it doesn't fit. The check is only performed if the bounds of e aren't
+// known to fit. A ckd_bounded is left unchanged if the value doesn't fit.
+template<typename T, typename E>
+ckd_constexpr ckd_inline bool ckd_set(T* res, E const& e)
+{
+  typedef typename ckd_node_of<E>::type N;
+  typedef ckd_bounds_of<T> R;
+  auto r = N(e).eval();
+  return ckd_set_value(ckd_num_within<typename N::lo,
+                                      typename N::hi,
+                                      typename R::lo,
+                                      typename R::hi>(),
+                       res,
+                       r.value)
+      | r.failed;
+}
+
+template<typename A, typename B>
+struct ckd_has_node
+    : std::enable_if<std::is_base_of<ckd_node, A>::value
+                     || std::is_base_of<ckd_node, B>::value>
+{};
+
+template<typename A, typename B, typename = typename ckd_has_node<A, B>::type>
+ckd_constexpr ckd_inline ckd_tree<ckd_node_add,
+                                  typename ckd_node_of<A>::type,
+                                  typename ckd_node_of<B>::type>
+operator+(A const& a, B const& b)
+{
+  return {a, b};
+}
+
+template<typename A, typename B, typename = typename ckd_has_node<A, B>::type>
+ckd_constexpr ckd_inline ckd_tree<ckd_node_sub,
+                                  typename ckd_node_of<A>::type,
+                                  typename ckd_node_of<B>::type>
+operator-(A const& a, B const& b)
+{
+  return {a, b};
+}
+
+template<typename A, typename B, typename = typename ckd_has_node<A, B>::type>
+ckd_constexpr ckd_inline ckd_tree<ckd_node_mul,
+                                  typename ckd_node_of<A>::type,
+                                  typename ckd_node_of<B>::type>
+operator*(A const& a, B const& b)
+{
+  return {a, b};
+}
+
+#endif
+
+/*
+ * Shapes. Code that walks N-dimensional arrays, e.g. tensors or images,
+ * computes `base + i * stride[0] + j * stride[1] + ...` for each element
+ * it visits. ckd_shape_init() checks once that every offset which could
+ * be reached is inside a buffer of `size` elements, after which computing
+ * an offset is plain integer arithmetic. Any partial sum of those terms
+ * is between the least and greatest reachable offsets, so it can't wrap
+ * either, provided each index is less than its extent. Strides count in
+ * elements and may be negative or zero. If stride is NULL then the array
+ * is contiguous and row major. True is returned if the shape won't fit,
+ * or the rank is greater than ckd_shape_max.
+ *
+ *     ckd_shape s;
+ *     size_t dim[3] = {h, w, 3};
+ *     ptrdiff_t ix[ckd_shape_max], off;
+ *     if (ckd_shape_init(&s, 3, dim, NULL, 0, n)) {
+ *       return EINVAL;
+ *     }
+ *     if (ckd_shape_begin(&s, ix, &off)) {
+ *       do {
+ *         pixels[off] = 0;
+ *       } while (ckd_shape_next(&s, ix, &off));
+ *     }
+ */
+
+#if defined(ckd_have_templates) || defined(ckd_have_generic)
+
+#  define ckd_shape_max 8
+
+typedef struct ckd_shape
+{
+  size_t rank;
+  ptrdiff_t base;
+  ptrdiff_t dim[ckd_shape_max];
+  ptrdiff_t stride[ckd_shape_max];
+} ckd_shape;
+
+ckd_inline bool ckd_shape_init(ckd_shape* s,
+                               size_t rank,
+                               size_t const* dim,
+                               ptrdiff_t const* stride,
+                               ptrdiff_t base,
+                               size_t size)
+{
+  bool o = rank > ckd_shape_max;
+  bool empty = false;
+  ptrdiff_t lo = base;
+  ptrdiff_t hi = base;
+  ptrdiff_t n = 1;
+  ptrdiff_t t = 0;
+  size_t k = o ? 0 : rank;
+  s->rank = rank;
+  s->base = base;
+  while (k--) {
+    o |= ckd_add(&s->dim[k], dim[k], 0);
+    if (stride) {
+      s->stride[k] = stride[k];
+    } else {
+      s->stride[k] = n;
+      o |= ckd_mul(&n, n, s->dim[k]);
+    }
+    if (s->dim[k]) {
+      o |= ckd_mul(&t, s->dim[k] - 1, s->stride[k]);
+      if (t < 0) {
+        o |= ckd_add(&lo, lo, t);
+      } else {
+        o |= ckd_add(&hi, hi, t);
+      }
+    } else {
+      empty = true;
+    }
+  }
+  if (!o && !empty) {
+    o |= lo < 0 || (!ckd_add(&t, size, 0) && hi >= t);
+  }
+  return o;
+}
+
+ckd_inline ptrdiff_t ckd_shape_offset(ckd_shape const* s, ptrdiff_t const* ix)
+{
+  ptrdiff_t z = s->base;
+  size_t k;
+  for (k = 0; k < s->rank; ++k) {
+    z += ix[k] * s->stride[k];
+  }
+  return z;
+}
+
+// Sets the indices to zero and the offset to the base, then returns true
+// unless the shape has no elements.
+ckd_inline bool ckd_shape_begin(ckd_shape const* s,
+                                ptrdiff_t* ix,
+                                ptrdiff_t* off)
+{
+  bool ok = true;
+  size_t k;
+  for (k = 0; k < s->rank; ++k) {
+    ix[k] = 0;
+    ok &= s->dim[k] > 0;
+  }
+  *off = s->base;
+  return ok;
+}
+
+// Advances the indices in row major order, and the offset with them,
+// returning false after the last element.
+ckd_inline bool ckd_shape_next(ckd_shape const* s,
+                               ptrdiff_t* ix,
+                               ptrdiff_t* off)
+{
+  size_t k = s->rank;
+  while (k--) {
+    if (++ix[k] < s->dim[k]) {
+      *off += s->stride[k];
+      return true;
+    }
+    *off -= (ix[k] - 1) * s->stride[k];
+    ix[k] = 0;
+  }
+  return false;
+}
+
+#endif
+
+/*
+ * Affine inductions. A loop like `for (i = 0; i < n; ++i) f(a + i * b)`
+ * visits values which are all between the first and the last, so they
+ * all fit in a type when those two do. ckd_affine(&z, a, b, n) checks
+ * that once, before the loop, storing the last value `a + (n - 1) * b`
+ * in z and returning true if any value would overflow, so the caller
+ * is able to choose between an unchecked loop and a checked one. It's
+ * exact, i.e. it only returns true if some iteration would overflow.
+ * When n is zero, there's nothing to check, and z isn't changed.
+ *
+ * Only the values themselves are proven to fit, not the product i * b
+ * nor i itself, so the unchecked loop should step an induction variable
+ * rather than computing `a + (int)i * b`, which may still overflow.
+ *
+ *     int last;
+ *     if (!ckd_affine(&last, base, step, n)) {
+ *       int v = base;
+ *       for (i = 0; i < n; ++i) {
+ *         if (i) {
+ *           v += step;  // always one of the values checked
+ *         }
+ *         a[i] = v;
+ *       }
+ *     } else {
+ *       ...
+ *     }
+ */
+
+#if defined(ckd_have_templates)
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_affine(T* res,
+                                         U start,
+                                         V step,
+                                         std::size_t n)
+{
+  T first = T();
+  ckd_uintmax m = 0;
+  bool neg = !ckd_sub(&m, 0, step);
+  bool o = false;
+  if (!n) {
+    return false;
+  }
+  if (!neg) {
+    m = static_cast<ckd_uintmax>(step);
+  }
+  o |= ckd_mul(&m, n - 1, m);
+  o |= ckd_add(&first, start, 0);
+  o |= neg ? ckd_sub(res, start, m) : ckd_add(res, start, m);
+  return o;
+}
+
+#elif defined(ckd_have_generic)
+
+/* a of signedness a_signed, plus or minus the unsigned b */
+#  ifdef ckd_have_polyfill
+#    define ckd_affine_op(op, S, res, a, b, a_signed) \
+      ckd_##op##_##S(res, a, b, a_signed)
+#  else
+#    define ckd_affine_op(op, S, res, a, b, a_signed) \
+      ((a_signed) ? __builtin_##op##_overflow((ckd_intmax)(a), b, res) \
+                  : __builtin_##op##_overflow(a, b, res))
+#  endif
+
+#  define ckd_declare_affine(S, T, P) \
+    ckd_inline bool ckd_##P##_##S(T* res, \
+                                  ckd_uintmax a, \
+                                  ckd_uintmax b, \
+                                  unsigned char ab_signed, \
+                                  size_t n) \
+    { \
+      T first; \
+      ckd_uintmax m = 0; \
+      unsigned char a_signed = ab_signed & 2; \
+      bool neg = (ab_signed & 1) && (ckd_intmax)b < 0; \
+      bool o = false; \
+      if (!n) { \
+        return false; \
+      } \
+      o |= ckd_umulo(&m, n - 1, neg ? 0 - b : b); \
+      o |= ckd_affine_op(add, S, &first, a, 0, a_signed); \
+      o |= neg ? ckd_affine_op(sub, S, res, a, m, a_signed) \
+               : ckd_affine_op(add, S, res, a, m, a_signed); \
+      return o; \
+    }
+
+ckd_each_int(ckd_declare_affine, affine)
+#  ifdef ckd_have_int128
+ckd_each_int128(ckd_declare_affine, affine)
+#  endif
+
+#  define ckd_affine(res, start, step, n) \
+    (_Generic(*(res), \
+         signed char: ckd_affine_schar, \
+         unsigned char: ckd_affine_uchar, \
+         signed short: ckd_affine_sshort, \
+         unsigned short: ckd_affine_ushort, \
+         signed int: ckd_affine_sint, \
+         unsigned int: ckd_affine_uint, \
+         signed long: ckd_affine_slong, \
+         unsigned long: ckd_affine_ulong, \
+         signed long long: ckd_affine_slonger, \
+         unsigned long long: ckd_affine_ulonger ckd_generic_int128( \
+             ckd_affine_sint128, ckd_affine_uint128))( \
+        (res), \
+        (ckd_uintmax)ckd_narrow(start), \
+        (ckd_uintmax)ckd_narrow(step), \
+        (ckd_is_signed(start) << 1) | ckd_is_signed(step), \
+        (n)))
+
+#endif
+
+/*
+ * Instrumented modes wrap ckd_add, ckd_sub and ckd_mul, and identify the
+ * types of the result and operands by their size in bytes times two, plus
+ * one if they're signed, e.g. 9 for int32_t.
+ */
+
+#if (defined(JTCKDINT_OPTION_STATS) && JTCKDINT_OPTION_STATS == 1 \
+     || defined(JTCKDINT_OPTION_USDT) && JTCKDINT_OPTION_USDT == 1) \
+    && (defined(ckd_have_templates) || defined(ckd_have_generic))
+#  ifdef ckd_have_templates
+template<typename T>
+struct ckd_type_id
+    : std::integral_constant<unsigned,
+                             sizeof(T) * 2
+                                 + (std::is_signed<T>::value
+                                    || std::is_same<T, ckd_i128>::value)>
+{};
+#  else
+#    define ckd_type_id(x) (sizeof(x) * 2 + ckd_is_signed(x))
+#  endif
+#endif
+
+/**
+ * JTCKDINT_OPTION_USDT
+ *   = 0: no tracepoints
+ *   = 1: fire the USDT probe jtckdint:overflow when an operation fails
+ *
+ * The probe is only reached on the failing branch, which the compiler
+ * lays out of line, and it's a nop until bpftrace or perf attaches. Its
+ * arguments are the operation (0 add, 1 sub, 2 mul), both operands as
+ * 64-bit integers, and the type ids of the result and operands. Wider
+ * operands are truncated, except that C passes zero for ckd_i128 limbs.
+ * Needs <sys/sdt.h> from systemtap, so GCC or Clang on Linux.
+ */
+#if defined(JTCKDINT_OPTION_USDT) && JTCKDINT_OPTION_USDT == 1 \
+    && (defined(ckd_have_templates) || defined(ckd_have_generic))
+#  if (defined(__GNUC__) || defined(__llvm__)) && ckd_has_include(<sys/sdt.h>)
+#    include <sys/sdt.h>
+#    define ckd_have_usdt
+#  else
+#    pragma message("USDT probes need <sys/sdt.h>")
+#  endif
+#endif
+
+#if defined(ckd_have_usdt) && defined(ckd_have_templates)
+
+template<typename T>
+ckd_inline long long ckd_usdt_arg(T x)
+{
+  return static_cast<long long>(x);
+}
+
+#  ifdef ckd_have_limbs
+ckd_inline long long ckd_usdt_arg(ckd_i128 x)
+{
+  return static_cast<long long>(ckd_i128_lo(x));
+}
+
+ckd_inline long long ckd_usdt_arg(ckd_u128 x)
+{
+  return static_cast<long long>(ckd_u128_lo(x));
+}
+#  endif
+
+// not constexpr, since it has inline assembly
+template<typename T, typename U, typename V>
+ckd_inline void ckd_usdt_probe(int op, U a, V b)
+{
+  STAP_PROBE6(jtckdint,
+              overflow,
+              op,
+              ckd_usdt_arg(a),
+              ckd_usdt_arg(b),
+              int(ckd_type_id<T>::value),
+              int(ckd_type_id<U>::value),
+              int(ckd_type_id<V>::value));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_usdt_add(T* res, U a, V b)
+{
+  bool o = ckd_add(res, a, b);
+  if (ckd_unlikely(o) && !ckd_is_constant_evaluated()) {
+    ckd_usdt_probe<T>(0, a, b);
+  }
+  return o;
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_usdt_sub(T* res, U a, V b)
+{
+  bool o = ckd_sub(res, a, b);
+  if (ckd_unlikely(o) && !ckd_is_constant_evaluated()) {
+    ckd_usdt_probe<T>(1, a, b);
+  }
+  return o;
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_usdt_mul(T* res, U a, V b)
+{
+  bool o = ckd_mul(res, a, b);
+  if (ckd_unlikely(o) && !ckd_is_constant_evaluated()) {
+    ckd_usdt_probe<T>(2, a, b);
+  }
+  return o;
+}
+
+#elif defined(ckd_have_usdt)
+
+// The operands are copied, so they're evaluated once, using a GNU
+// statement expression, which every compiler with <sys/sdt.h> has.
+#  define ckd_usdt_expr(op, base, res, a, b) \
+    __extension__({ \
+      __typeof__(a) ckd_a_ = (a); \
+      __typeof__(b) ckd_b_ = (b); \
+      bool ckd_o_ = base(res, ckd_a_, ckd_b_); \
+      if (ckd_unlikely(ckd_o_)) { \
+        STAP_PROBE6(jtckdint, \
+                    overflow, \
+                    op, \
+                    (long long)ckd_narrow(ckd_a_), \
+                    (long long)ckd_narrow(ckd_b_), \
+                    (int)ckd_type_id(*(res)), \
+                    (int)ckd_type_id(ckd_a_), \
+                    (int)ckd_type_id(ckd_b_)); \
+      } \
+      ckd_o_; \
+    })
+
+#  define ckd_usdt_add(res, a, b) ckd_usdt_expr(0, ckd_base_add, res, a, b)
+#  define ckd_usdt_sub(res, a, b) ckd_usdt_expr(1, ckd_base_sub, res, a, b)
+#  define ckd_usdt_mul(res, a, b) ckd_usdt_expr(2, ckd_base_mul, res, a, b)
+
+#  undef ckd_add
+#  undef ckd_sub
+#  undef ckd_mul
+#  define ckd_add ckd_usdt_add
+#  define ckd_sub ckd_usdt_sub
+#  define ckd_mul ckd_usdt_mul
+
+#endif
+
+/**
+ * JTCKDINT_OPTION_STATS
+ *   = 0: count nothing
+ *   = 1: count the calls and failures of each ckd_add, ckd_sub and ckd_mul
+ *
+ * Each call site, i.e. its file, line, operation and types, gets a slot
+ * in a hash table that's local to the calling thread, so counting needs
+ * no locked instructions. The table is allocated and registered by
+ * libjtckdint.a the first time a thread misses, and ckd_stats_dump()
+ * merges the tables of every thread into a csv file, which
+ * ckd_stats_atexit() arranges to be done when the program exits. Since
+ * other threads may be dumping, the slots are stored and loaded with
+ * relaxed atomics, which are still plain moves on x86.
+ */
+#if defined(JTCKDINT_OPTION_STATS) && JTCKDINT_OPTION_STATS == 1 \
+    && (defined(ckd_have_templates) || defined(ckd_have_generic))
+#  define ckd_have_stats
+
+#  if defined(__GNUC__) || defined(__llvm__)
+#    define ckd_thread_local __thread
+#  elif defined(_MSC_VER)
+#    define ckd_thread_local __declspec(thread)
+#  elif defined(ckd_have_templates)
+#    define ckd_thread_local thread_local
+#  else
+#    define ckd_thread_local _Thread_local
+#  endif
+
+#  define ckd_stats_slots 4096
+
+// Only the owning thread writes its table, so it may read it plainly.
+// MSVC gives volatile accesses of aligned words the same guarantees.
+#  if defined(__GNUC__) || defined(__llvm__)
+#    define ckd_stats_load(x, order) __atomic_load_n(&(x), __ATOMIC_##order)
+#    define ckd_stats_store(x, v, order) \
+      __atomic_store_n(&(x), v, __ATOMIC_##order)
+#    define ckd_stats_u64 unsigned long long __attribute__((__aligned__(8)))
+#    define ckd_stats_volatile
+#  else
+#    define ckd_stats_load(x, order) (x)
+#    define ckd_stats_store(x, v, order) ((x) = (v))
+#    define ckd_stats_u64 unsigned long long
+#    define ckd_stats_volatile volatile
+#  endif
+
+typedef struct ckd_stats_site
+{
+  char const* ckd_stats_volatile file;
+  ckd_stats_u64 ckd_stats_volatile key; /* line, op, and types of res, a, b */
+  ckd_stats_u64 ckd_stats_volatile calls;
+  ckd_stats_u64 ckd_stats_volatile fails;
+} ckd_stats_site;
+
+typedef struct ckd_stats_table
+{
+  ckd_stats_site site[ckd_stats_slots];
+  ckd_stats_site spill; /* call sites that didn't fit */
+  struct ckd_stats_table* next;
+} ckd_stats_table;
+
+#  ifdef ckd_have_templates
+extern "C" {
+#  endif
+
+extern ckd_thread_local ckd_stats_table* ckd_stats_tls;
+ckd_stats_site* ckd_stats_insert(char const* file, unsigned long long key);
+int ckd_stats_dump(char const* path);
+int ckd_stats_atexit(char const* path);
+
+#  ifdef ckd_have_templates
+}
+#  endif
+
+#  define ckd_stats_hash(file, key) \
+    ((size_t)(((unsigned long long)(size_t)(file) ^ (key)) \
+              * 0x9e3779b97f4a7c15ull >> 52))
+
+/* ops are 0, 1 and 2 for add, sub and mul, and types are ckd_type_id */
+#  define ckd_stats_key(line, op, t, u, v) \
+    ((unsigned long long)(line) << 32 | (op) << 24 | (t) << 16 | (u) << 8 \
+     | (v))
+
+// Sites that aren't in their home slot, or a thread's first call, take
+// the slow path through the library.
+ckd_inline bool ckd_stats_count(char const* file,
+                                unsigned long long key,
+                                bool failed)
+{
+  ckd_stats_table* t = ckd_stats_tls;
+  ckd_stats_site* s = t ? &t->site[ckd_stats_hash(file, key)] : 0;
+  if (ckd_unlikely(!s || s->file != file || s->key != key)) {
+    s = ckd_stats_insert(file, key);
+  }
+  ckd_stats_store(s->calls, s->calls + 1, RELAXED);
+  ckd_stats_store(s->fails, s->fails + failed, RELAXED);
+  return failed;
+}
+
+#  ifdef ckd_have_usdt
+#    define ckd_stats_base(op) ckd_usdt_##op
+#  elif defined(ckd_have_templates)
+#    define ckd_stats_base(op) ckd_##op
+#  else
+#    define ckd_stats_base(op) ckd_base_##op
+#  endif
+
+#  ifdef ckd_have_templates
+
+template<int Op, typename T, typename U, typename V>
+struct ckd_stats_op
+    : std::integral_constant<unsigned long long,
+                             ckd_stats_key(0,
+                                           Op,
+                                           ckd_type_id<T>::value,
+                                           ckd_type_id<U>::value,
+                                           ckd_type_id<V>::value)>
+{};
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_stats_add(
+    char const* file, unsigned long long line, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_add(res, a, b)
+             : ckd_stats_count(file,
+                               line << 32 | ckd_stats_op<0, T, U, V>::value,
+                               ckd_stats_base(add)(res, a, b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_stats_sub(
+    char const* file, unsigned long long line, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_sub(res, a, b)
+             : ckd_stats_count(file,
+                               line << 32 | ckd_stats_op<1, T, U, V>::value,
+                               ckd_stats_base(sub)(res, a, b));
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_stats_mul(
+    char const* file, unsigned long long line, T* res, U a, V b)
+{
+  return ckd_is_constant_evaluated()
+             ? ckd_mul(res, a, b)
+             : ckd_stats_count(file,
+                               line << 32 | ckd_stats_op<2, T, U, V>::value,
+                               ckd_stats_base(mul)(res, a, b));
+}
+
+#  else
+
+#    define ckd_stats_expr(code, op, res, a, b) \
+      ckd_stats_count(__FILE__, \
+                      ckd_stats_key(__LINE__, \
+                                    code, \
+                                    ckd_type_id(*(res)), \
+                                    ckd_type_id(a), \
+                                    ckd_type_id(b)), \
+                      ckd_stats_base(op)(res, a, b))
+
+#    undef ckd_add
+#    undef ckd_sub
+#    undef ckd_mul
+#    define ckd_add(res, a, b) ckd_stats_expr(0, add, res, a, b)
+#    define ckd_sub(res, a, b) ckd_stats_expr(1, sub, res, a, b)
+#    define ckd_mul(res, a, b) ckd_stats_expr(2, mul, res, a, b)
+
+#  endif
+#endif
+
+#if defined(ckd_have_site)
+
+#  ifdef ckd_have_stats
+#    define ckd_site_expr(op, res, a, b) ckd_stats_##op(file, line, res, a, b)
+#  elif defined(ckd_have_usdt)
+#    define ckd_site_expr(op, res, a, b) \
+      ((void)file, (void)line, ckd_usdt_##op(res, a, b))
+#  else
+#    define ckd_site_expr(op, res, a, b) \
+      ((void)file, (void)line, ckd_##op(res, a, b))
+#  endif
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_add(
+    T* res, U a, V b, char const* file, unsigned line)
+{
+  return ckd_site_expr(add, res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_sub(
+    T* res, U a, V b, char const* file, unsigned line)
+{
+  return ckd_site_expr(sub, res, a, b);
+}
+
+template<typename T, typename U, typename V>
+ckd_constexpr ckd_inline bool ckd_site_mul(
+    T* res, U a, V b, char const* file, unsigned line)
+{
+  return ckd_site_expr(mul, res, a, b);
+}
+
+#  undef ckd_add
+#  undef ckd_sub
+#  undef ckd_mul
+#  define ckd_add ckd_site_add
+#  define ckd_sub ckd_site_sub
+#  define ckd_mul ckd_site_mul
+
+#endif
 
-#  endif /* GNU */
-#endif /* stdckdint.h */
 #endif /* JTCKDINT_H_ */
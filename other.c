@@ -1,9 +1,25 @@
+#include <stdint.h>
+
 #include "jtckdint.h"
 
 bool test_odr(int a, int b);
+bool other_affine(int8_t* res, int a, int b, size_t n);
+bool other_affine64(uint64_t* res, uint64_t a, int b, size_t n);
 
 bool test_odr(int a, int b)
 {
   int c;
   return !ckd_add(&c, a, b) && !ckd_sub(&c, a, b) && !ckd_mul(&c, a, b);
 }
+
+// this file doesn't ask for the extras, so with the builtins ckd_affine
+// doesn't go through the polyfill, unlike in test.c
+bool other_affine(int8_t* res, int a, int b, size_t n)
+{
+  return ckd_affine(res, a, b, n);
+}
+
+bool other_affine64(uint64_t* res, uint64_t a, int b, size_t n)
+{
+  return ckd_affine(res, a, b, n);
+}
@@ -13,22 +13,43 @@
 // TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#if defined(__unix__) || defined(__APPLE__)
+#  define _POSIX_C_SOURCE 200809L
+#  define HAVE_POSIX
+#endif
+
 #include <assert.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_POSIX
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#define JTCKDINT_OPTION_EXTRAS 1
 #include "jtckdint.h"
 
 #ifdef __cplusplus
 #  define nil nullptr
 #  define cast(T, x) (static_cast<T>(x))
 #  define align(x) alignas(x)
+#  define tls thread_local
 #else
 #  define nil 0
 #  define cast(T, x) ((T)(x))
 #  define align(x) _Alignas(x)
+#  if defined(_MSC_VER)
+#    define tls __declspec(thread)
+#  else
+#    define tls _Thread_local
+#  endif
 #endif
 
 #define TMIN_UINT(T) (cast(T, 0))
@@ -125,21 +146,26 @@ FOR_TYPES(X)
 #undef X
 #undef Y
 
-static FILE* reference;
-static unsigned char ref;
-static size_t size;
-align(16) static unsigned char buffer[16];
-static long offset;
-static int i;
-static int j;
-static char const* t_type;
-static char const* u_type;
-static char const* v_type;
-static char const* op;
-static void const* u_ptr;
-static int (*u_stringify)(void const*, char*);
-static void const* v_ptr;
-static int (*v_stringify)(void const*, char*);
+// Each section of the reference is checked by its own thread, reading
+// records in place from the mapped file, so this state is per thread.
+static unsigned char* reference;
+static size_t reference_size;
+static tls unsigned char const* cursor;
+static tls unsigned char const* section_end;
+static tls unsigned char ref;
+static tls size_t size;
+static tls unsigned char const* buffer;
+static tls long offset;
+static tls int i;
+static tls int j;
+static tls char const* t_type;
+static tls char const* u_type;
+static tls char const* v_type;
+static tls char const* op;
+static tls void const* u_ptr;
+static tls int (*u_stringify)(void const*, char*);
+static tls void const* v_ptr;
+static tls int (*v_stringify)(void const*, char*);
 
 #define read_8() (cast(u8, buffer[0]))
 #define read_16() \
@@ -161,12 +187,21 @@ static int (*v_stringify)(void const*, char*);
     (cast(u128, (cast(u128, read_64_(0)) << 64) | cast(u128, read_64_(1))))
 #endif
 
+static u64 read_be(unsigned char const* p, int n)
+{
+  u64 x = 0;
+  while (n--) {
+    x = x << 8 | *p++;
+  }
+  return x;
+}
+
 #define STRINGIFY_BUFFER 41
 
-static char c1[STRINGIFY_BUFFER];
-static char c2[STRINGIFY_BUFFER];
-static char c3[STRINGIFY_BUFFER];
-static char c4[STRINGIFY_BUFFER];
+static tls char c1[STRINGIFY_BUFFER];
+static tls char c2[STRINGIFY_BUFFER];
+static tls char c3[STRINGIFY_BUFFER];
+static tls char c4[STRINGIFY_BUFFER];
 
 static void report_mismatch(bool o1, bool o2, int i1, int i2, int i3, int i4)
 {
@@ -218,30 +253,85 @@ static void report_mismatch(bool o1, bool o2, int i1, int i2, int i3, int i4)
 FOR_TYPES(X)
 #undef X
 
+// Reads the header of test.bin, see corpus.c, and finds the section of
+// records for the result type, returning false if there isn't one.
+static bool begin_section(unsigned type)
+{
+  size_t k = 0;
+  size_t n = 0;
+  unsigned char const* p = reference;
+  if (reference_size < 16 || memcmp(p, "JTCKDINT", 8) || read_be(p + 8, 4) != 2)
+  {
+    assert(fprintf(stderr, "test.bin is not a version 2 corpus\n") >= 0);
+    return false;
+  }
+  n = cast(size_t, read_be(p + 12, 4));
+  for (k = 0; k != n && 16 + (k + 1) * 24 <= reference_size; ++k) {
+    unsigned char const* e = p + 16 + k * 24;
+    u64 start = read_be(e + 8, 8);
+    u64 length = read_be(e + 16, 8);
+    if (read_be(e, 4) == type && start <= reference_size
+        && length <= reference_size - start)
+    {
+      cursor = reference + start;
+      section_end = cursor + length;
+      return true;
+    }
+  }
+#define msg "test.bin has no section for %s\n"
+  assert(fprintf(stderr, msg, t_type) >= 0);
+#undef msg
+  return false;
+}
+
+// Checks that the records a pass doesn't skip were all consumed.
+static bool end_section(bool limbs)
+{
+#ifndef ckd_have_int128
+  while (cursor != section_end && ((*cursor & 0x80) != 0) != limbs) {
+    cursor += 1 + (*cursor & 0x3F);
+  }
+#else
+  (void)limbs;
+#endif
+  if (cursor != section_end) {
+#define msg "Section %s was not read to completion. %ld bytes left.\n"
+    assert(fprintf(stderr, msg, t_type, cast(long, section_end - cursor))
+           >= 0);
+#undef msg
+    return true;
+  }
+  return false;
+}
+
+static void read_record(void)
+{
+  assert(cursor < section_end);
+  offset = cast(long, cursor - reference);
+  ref = *cursor++;
+  size = cast(size_t, ref & 0x3F);
+  assert(size <= cast(size_t, section_end - cursor));
+  buffer = cursor;
+  cursor += size;
+}
+
 static void read_next(void)
 {
-  offset = ftell(reference);
 #ifdef ckd_have_int128
-  assert(fread(&ref, 1, 1, reference) == 1);
-  size = cast(size_t, ref & 0x3F);
-  assert(fread(buffer, 1, size, reference) == size);
+  read_record();
 #else
-  for (;;) {
-    assert(fread(&ref, 1, 1, reference) == 1);
-    size = cast(size_t, ref & 0x3F);
-    if ((ref & 0x80) == 0) {
-      assert(fread(buffer, 1, size, reference) == size);
-      return;
-    }
-    assert(fseek(reference, cast(long, size), SEEK_CUR) == 0);
-    offset += 1 + cast(long, size);
-  }
+  do {
+    read_record();
+  } while ((ref & 0x80) != 0);
 #endif
 }
 
 static char const* str_ckd_add = "ckd_add";
 static char const* str_ckd_sub = "ckd_sub";
 static char const* str_ckd_mul = "ckd_mul";
+static char const* str_ckd_add_n = "ckd_add_n";
+static char const* str_ckd_sub_n = "ckd_sub_n";
+static char const* str_ckd_mul_n = "ckd_mul_n";
 
 #define check_next(T, f) \
   do { \
@@ -251,6 +341,11 @@ static char const* str_ckd_mul = "ckd_mul";
     if (mismatch_##T(o, z)) { \
       return true; \
     } \
+    op = str_##f##_n; \
+    o = f##_n(&z, &x, &y, 1) != 1; \
+    if (mismatch_##T(o, z)) { \
+      return true; \
+    } \
   } while (0)
 
 #define M(T, U, V) \
@@ -284,11 +379,25 @@ static char const* str_ckd_mul = "ckd_mul";
   M(T, U, i64) \
   WITH_128(M)(T, U, i128)
 
+#define SECTION_u8 0x01
+#define SECTION_u16 0x02
+#define SECTION_u32 0x04
+#define SECTION_u64 0x08
+#define SECTION_u128 0x10
+#define SECTION_i8 0x81
+#define SECTION_i16 0x82
+#define SECTION_i32 0x84
+#define SECTION_i64 0x88
+#define SECTION_i128 0x90
+
 #define MMM(T) \
   static bool test_##T(void) \
   { \
     bool o = false; \
     t_type = str_##T; \
+    if (!begin_section(SECTION_##T)) { \
+      return true; \
+    } \
     MM(T, u8) \
     MM(T, u16) \
     MM(T, u32) \
@@ -301,7 +410,7 @@ static char const* str_ckd_mul = "ckd_mul";
     WITH_128(MM)(T, i128) \
     v_ptr = nil; \
     u_ptr = nil; \
-    return false; \
+    return end_section(false); \
   }
 
 MMM(u8)
@@ -317,6 +426,1240 @@ WITH_128(MMM)(i128)
 EAT()
 /* clang-format on */
 
+#ifdef ckd_have_limbs
+
+// Without __int128 the 128-bit records are checked on a second pass
+// using the two-limb types, which only support scalar arithmetic.
+
+typedef ckd_i128 i128;
+typedef ckd_u128 u128;
+
+#  define L128(hi, lo) {cast(u64, lo), cast(u64, hi)}
+#  define NEAR(hi, lo, d) \
+    L128(hi, lo d 0), L128(hi, lo d 1), L128(hi, lo d 2), L128(hi, lo d 3), \
+        L128(hi, lo d 4)
+#  define SMALL \
+    L128(0, 0), L128(0, 1), L128(0, 2), L128(0, 3), L128(0, 4), L128(0, 5), \
+        L128(0, 6), L128(-1, -1), L128(-1, -2), L128(-1, -3), L128(-1, -4), \
+        L128(-1, -5), L128(-1, -6)
+
+static u128 const ku128[] = {
+    SMALL,
+    NEAR(0, 0, +),
+    NEAR(-1, -1, -),
+    NEAR(0, 0, +),
+    NEAR(INT64_MAX, -1, -),
+};
+
+static i128 const ki128[] = {
+    SMALL,
+    NEAR(INT64_MIN, 0, +),
+    NEAR(INT64_MAX, -1, -),
+    NEAR(INT64_MIN / 2, 0, +),
+    NEAR(INT64_MAX / 2, -1, -),
+};
+
+static int stringify_limbs(u64 hi, u64 lo, bool s, char* c)
+{
+  int k = 0;
+  int p = STRINGIFY_BUFFER;
+  if (s) {
+    lo = 0 - lo;
+    hi = ~hi + !lo;
+  }
+  c[--p] = 0;
+  do {
+    u64 r = 0;
+    u64 w[4];
+    w[0] = hi >> 32;
+    w[1] = hi & 0xffffffff;
+    w[2] = lo >> 32;
+    w[3] = lo & 0xffffffff;
+    for (k = 0; k != 4; ++k) {
+      u64 d = r << 32 | w[k];
+      w[k] = d / 10;
+      r = d % 10;
+    }
+    hi = w[0] << 32 | w[1];
+    lo = w[2] << 32 | w[3];
+    c[--p] = '0' + cast(char, r);
+  } while (hi | lo);
+  if (s) {
+    c[--p] = '-';
+  }
+  memset(c, ' ', cast(size_t, p));
+  return p;
+}
+
+#  define X(S, H) \
+    static char const* str_##S##128 = #S "128_t"; \
+    static int stringify_##S##128(void const* x_, char* c) \
+    { \
+      S##128 x = *cast(S##128 const*, x_); \
+      return stringify_limbs(cast(u64, ckd_##S##128_hi(x)), \
+                             ckd_##S##128_lo(x), \
+                             SIGNED_##S && cast(i64, ckd_##S##128_hi(x)) < 0, \
+                             c); \
+    } \
+    static bool mismatch_##S##128(bool o1, S##128 z1) \
+    { \
+      bool o2 = (ref & 0x40) != 0; \
+      S##128 z2 = ckd_##S##128_make(cast(H, read_64_(0)), read_64_(1)); \
+      if (o1 == o2 && ckd_##S##128_hi(z1) == ckd_##S##128_hi(z2) \
+          && ckd_##S##128_lo(z1) == ckd_##S##128_lo(z2)) { \
+        return false; \
+      } \
+      report_mismatch(o1, \
+                      o2, \
+                      stringify_##S##128(&z1, c1), \
+                      stringify_##S##128(&z2, c2), \
+                      u_stringify(u_ptr, c3), \
+                      v_stringify(v_ptr, c4)); \
+      return true; \
+    }
+X(u, u64)
+X(i, i64)
+#  undef X
+
+static void read_next_limbs(void)
+{
+  do {
+    read_record();
+  } while ((ref & 0x80) == 0);
+}
+
+#  define check_limbs(T, f) \
+    do { \
+      op = str_##f; \
+      read_next_limbs(); \
+      o = f(&z, x, y); \
+      if (mismatch_##T(o, z)) { \
+        return true; \
+      } \
+    } while (0)
+
+#  define LIMBS_u8 0
+#  define LIMBS_u16 0
+#  define LIMBS_u32 0
+#  define LIMBS_u64 0
+#  define LIMBS_u128 1
+#  define LIMBS_i8 0
+#  define LIMBS_i16 0
+#  define LIMBS_i32 0
+#  define LIMBS_i64 0
+#  define LIMBS_i128 1
+#  define ANY_000 0
+#  define ANY_001 1
+#  define ANY_010 1
+#  define ANY_011 1
+#  define ANY_100 1
+#  define ANY_101 1
+#  define ANY_110 1
+#  define ANY_111 1
+#  define ANY_LIMBS(T, U, V) \
+    CAT(ANY_, CAT(LIMBS_##T, CAT(LIMBS_##U, LIMBS_##V)))
+
+#  define LM_(T, U, V) \
+    u_type = str_##U; \
+    v_type = str_##V; \
+    for (i = 0; i != cast(int, sizeof(k##U) / sizeof(k##U[0])); ++i) { \
+      U x = k##U[i]; \
+      u_ptr = &x; \
+      u_stringify = stringify_##U; \
+      for (j = 0; j != cast(int, sizeof(k##V) / sizeof(k##V[0])); ++j) { \
+        T z; \
+        V y = k##V[j]; \
+        v_ptr = &y; \
+        v_stringify = stringify_##V; \
+        check_limbs(T, ckd_add); \
+        check_limbs(T, ckd_sub); \
+        check_limbs(T, ckd_mul); \
+      } \
+    }
+#  define LM(T, U, V) IF(ANY_LIMBS(T, U, V))(LM_, EAT)(T, U, V)
+
+/* clang-format off */
+#  define FOR_LIMB_TYPES(F) \
+    F(u8) \
+    F(u16) \
+    F(u32) \
+    F(u64) \
+    F(u128) \
+    F(i8) \
+    F(i16) \
+    F(i32) \
+    F(i64) \
+    F(i128)
+
+#  define LMM(T, U) \
+    LM(T, U, u8) \
+    LM(T, U, u16) \
+    LM(T, U, u32) \
+    LM(T, U, u64) \
+    LM(T, U, u128) \
+    LM(T, U, i8) \
+    LM(T, U, i16) \
+    LM(T, U, i32) \
+    LM(T, U, i64) \
+    LM(T, U, i128)
+
+#  define LMMM(T) \
+    static bool test_limbs_##T(void) \
+    { \
+      bool o = false; \
+      t_type = str_##T; \
+      if (!begin_section(SECTION_##T)) { \
+        return true; \
+      } \
+      LMM(T, u8) \
+      LMM(T, u16) \
+      LMM(T, u32) \
+      LMM(T, u64) \
+      LMM(T, u128) \
+      LMM(T, i8) \
+      LMM(T, i16) \
+      LMM(T, i32) \
+      LMM(T, i64) \
+      LMM(T, i128) \
+      v_ptr = nil; \
+      u_ptr = nil; \
+      return end_section(true); \
+    }
+FOR_LIMB_TYPES(LMMM)
+EAT()
+/* clang-format on */
+
+#endif
+
+#define SPAN 1000
+
+static i32 span_x[SPAN];
+static i64 span_y[SPAN];
+static i32 span_z[SPAN];
+
+static bool test_span(void)
+{
+  size_t k = 0;
+  size_t first = 0;
+  for (k = 0; k != SPAN; ++k) {
+    span_x[k] = cast(i32, k);
+    span_y[k] = cast(i64, TMAX_INT(i32)) - 600;
+  }
+  first = ckd_add_n(span_z, span_x, span_y, SPAN);
+  for (k = 0; k != SPAN; ++k) {
+    i32 z = 0;
+    if (ckd_add(&z, span_x[k], span_y[k]) != (k >= 601) || z != span_z[k]) {
+      break;
+    }
+  }
+  if (first != 601 || k != SPAN) {
+#define msg "Mismatch in ckd_add_n: first = %lu, lane = %lu\n"
+#define args cast(unsigned long, first), cast(unsigned long, k)
+    assert(fprintf(stderr, msg, args) >= 0);
+#undef args
+#undef msg
+    return true;
+  }
+  return false;
+}
+
+#define check_sum(T, a, n) \
+  do { \
+    T z1 = 0; \
+    T z2 = 0; \
+    bool o1 = false; \
+    bool o2 = ckd_sum(&z2, a, n); \
+    for (k = 0; k != n; ++k) { \
+      o1 |= ckd_add(&z1, z1, a[k]); \
+    } \
+    if (o1 != o2 || z1 != z2) { \
+      report_reduce_mismatch("ckd_sum", #T, #a, ""); \
+      return true; \
+    } \
+  } while (0)
+
+#define check_dot(T, a, b, n) \
+  do { \
+    T z1 = 0; \
+    T z2 = 0; \
+    bool o1 = false; \
+    bool o2 = ckd_dot(&z2, a, b, n); \
+    for (k = 0; k != n; ++k) { \
+      T p = 0; \
+      o1 |= ckd_mul(&p, a[k], b[k]); \
+      o1 |= ckd_add(&z1, z1, p); \
+    } \
+    if (o1 != o2 || z1 != z2) { \
+      report_reduce_mismatch("ckd_dot", #T, #a, #b); \
+      return true; \
+    } \
+  } while (0)
+
+static void report_reduce_mismatch(char const* f,
+                                   char const* t,
+                                   char const* a,
+                                   char const* b)
+{
+#define msg "Mismatch in %s(%s, %s, %s)\n"
+  assert(fprintf(stderr, msg, f, t, a, b) >= 0);
+#undef msg
+}
+
+static bool test_reduce(void)
+{
+  size_t k = 0;
+  for (k = 0; k != SPAN; ++k) {
+    span_x[k] = cast(i32, k) - 300;
+    span_y[k] = cast(i64, k) * 3;
+  }
+  check_sum(i8, span_x, SPAN);
+  check_sum(i16, span_x, SPAN);
+  check_sum(u16, span_x, SPAN);
+  check_sum(i32, span_x, SPAN);
+  check_sum(u32, span_y, SPAN);
+  check_sum(i64, span_y, SPAN);
+  check_sum(u64, ki64, sizeof(ki64) / sizeof(ki64[0]));
+  check_sum(i32, ku16, sizeof(ku16) / sizeof(ku16[0]));
+  check_dot(i16, span_x, span_y, SPAN);
+  check_dot(i32, span_x, span_y, SPAN);
+  check_dot(u32, span_x, span_y, SPAN);
+  check_dot(i64, span_x, span_y, SPAN);
+  check_dot(u64, span_y, span_y, SPAN);
+  check_dot(i64, ki32, ku32, sizeof(ki32) / sizeof(ki32[0]));
+  check_dot(u8, ku8, ki8, sizeof(ku8) / sizeof(ku8[0]));
+  return false;
+}
+
+#define check_muladd(T, U, V, W, c) \
+  do { \
+    T t = 0; \
+    long v = cast(long, cast(U, a)) * cast(V, b) + cast(W, c); \
+    bool o = ckd_muladd(&t, cast(U, a), cast(V, b), cast(W, c)); \
+    bool w = v < cast(long, MIN_##T) || v > cast(long, MAX_##T); \
+    if (o != w || t != cast(T, cast(unsigned long, v))) { \
+      report_muladd_mismatch(#T, #U, #V, #W, v); \
+      return true; \
+    } \
+  } while (0)
+
+#define MIN_i8 INT8_MIN
+#define MAX_i8 INT8_MAX
+#define MIN_u8 0
+#define MAX_u8 UINT8_MAX
+#define MIN_i16 INT16_MIN
+#define MAX_i16 INT16_MAX
+
+static void report_muladd_mismatch(
+    char const* t, char const* u, char const* v, char const* w, long x)
+{
+#define msg "Mismatch in ckd_muladd(%s, %s, %s, %s) = %ld\n"
+  assert(fprintf(stderr, msg, t, u, v, w, x) >= 0);
+#undef msg
+}
+
+static bool test_muladd(void)
+{
+  int a = 0;
+  int b = 0;
+  i64 z = 0;
+  u64 y = 0;
+  for (a = 0; a != 256; ++a) {
+    for (b = 0; b != 256; ++b) {
+      check_muladd(i8, i8, i8, i8, -128);
+      check_muladd(i8, i8, u8, i16, 300);
+      check_muladd(u8, i8, i8, i8, 1);
+      check_muladd(u8, u8, u8, i16, -300);
+      check_muladd(i16, i8, u8, u8, 255);
+      check_muladd(i16, u8, u8, i16, -32768);
+    }
+  }
+  if (ckd_muladd(&z, cast(i64, -4294967296), cast(i64, 4294967296), ~0ull)
+      || z != -1
+      || ckd_muladd2(&z, cast(i64, 1) << 62, 4, -(cast(i64, 1) << 62), 4, 5)
+      || z != 5 || !ckd_muladd(&y, cast(u64, 1) << 40, 1u << 30, 16)
+      || y != 16
+      || !ckd_muladd2(&y, cast(u64, 1) << 63, 1, cast(u64, 1) << 63, 1, 0)
+      || y != 0)
+  {
+    report_muladd_mismatch("i64", "i64", "i64", "u64", 0);
+    return true;
+  }
+  return false;
+}
+
+static bool test_ctx(void)
+{
+  ckd_ctx c;
+  i8 x = 0;
+  u32 y = 0;
+  i64 z = 0;
+  bool bad = false;
+  ckd_ctx_init(&c);
+  ckd_ctx_add(&c, &x, 100, 27);
+  ckd_ctx_sub(&c, &y, x, cast(i64, -1));
+  ckd_ctx_mul(&c, &z, y, -3);
+  ckd_ctx_muladd(&c, &z, z, 2, 768);
+  bad |= ckd_ctx_failed(&c) || x != 127 || y != 128 || z != 0;
+  ckd_ctx_add(&c, &x, x, 1);
+  ckd_ctx_sub(&c, &y, y, 1u);
+  bad |= !ckd_ctx_failed(&c) || x != -128 || y != 127;
+  if (bad) {
+#define msg "Mismatch in ckd_ctx\n"
+    assert(fprintf(stderr, msg) >= 0);
+#undef msg
+  }
+  return bad;
+}
+
+static int or_calls;
+
+static ckd_cold void or_handler(void)
+{
+  ++or_calls;
+}
+
+static bool test_or(void)
+{
+  i8 x = 0;
+  u32 y = 0;
+  i64 z = 0;
+  bool bad = false;
+  or_calls = 0;
+  ckd_add_or_trap(&x, 100, 27);
+  ckd_sub_or_trap(&y, x, cast(i64, -1));
+  ckd_mul_or_trap(&z, y, -3);
+  bad |= x != 127 || y != 128 || z != -384;
+  ckd_add_or(&x, x, 1, or_handler);
+  ckd_sub_or(&y, y, 1u, or_handler);
+  ckd_mul_or(&y, y, -1, or_handler);
+  bad |= or_calls != 2 || x != -128 || y != cast(u32, -127);
+  if (bad) {
+#define msg "Mismatch in ckd_or\n"
+    assert(fprintf(stderr, msg) >= 0);
+#undef msg
+  }
+  return bad;
+}
+
+#define check_sat(F, T, U, V, OP) \
+  do { \
+    T t = 0; \
+    long v = cast(long, cast(U, a)) OP cast(V, b); \
+    bool o = F(&t, cast(U, a), cast(V, b)); \
+    bool w = v < cast(long, MIN_##T) || v > cast(long, MAX_##T); \
+    v = v < cast(long, MIN_##T) ? MIN_##T : v; \
+    v = v > cast(long, MAX_##T) ? MAX_##T : v; \
+    if (o != w || t != v) { \
+      report_sat_mismatch(#F, #T, #U, #V, v); \
+      return true; \
+    } \
+  } while (0)
+
+#define check_sats(T, U, V) \
+  check_sat(ckd_sat_add, T, U, V, +); \
+  check_sat(ckd_sat_sub, T, U, V, -); \
+  check_sat(ckd_sat_mul, T, U, V, *)
+
+static void report_sat_mismatch(
+    char const* f, char const* t, char const* u, char const* v, long x)
+{
+#define msg "Mismatch in %s(%s, %s, %s) = %ld\n"
+  assert(fprintf(stderr, msg, f, t, u, v, x) >= 0);
+#undef msg
+}
+
+static bool test_sat(void)
+{
+  int a = 0;
+  int b = 0;
+  size_t k = 0;
+  i16 x[SPAN];
+  i16 d[SPAN];
+  i64 z = 0;
+  u64 y = 0;
+  for (a = 0; a != 256; ++a) {
+    for (b = 0; b != 256; ++b) {
+      check_sats(i8, i8, i8);
+      check_sats(i8, u8, i8);
+      check_sats(u8, u8, u8);
+      check_sats(u8, i8, u8);
+      check_sats(u8, i8, i8);
+      check_sats(i16, i8, u8);
+      check_sats(i16, u8, u8);
+    }
+  }
+  for (k = 0; k != SPAN; ++k) {
+    x[k] = cast(i16, cast(int, k) * 331 - 32000);
+    d[k] = cast(i16, cast(int, k) * 300);
+  }
+  if (ckd_sat_add_n(x, x, d, SPAN) != 103 || x[102] != 32362
+      || x[103] != 32767 || x[SPAN - 1] != -32768)
+  {
+    report_sat_mismatch("ckd_sat_add_n", "i16", "i16", "i16", x[103]);
+    return true;
+  }
+  if (!ckd_sat_add(&z, ~0ull, 1) || z != INT64_MAX
+      || !ckd_sat_sub(&z, INT64_MIN, ~0ull) || z != INT64_MIN
+      || !ckd_sat_mul(&z, ~0ull, -2) || z != INT64_MIN
+      || ckd_sat_mul(&y, INT64_MIN, -1) || y != cast(u64, 1) << 63
+      || !ckd_sat_sub(&y, cast(i64, -5), 3u) || y != 0
+      || !ckd_sat_sub(&z, 1ull, ~0ull) || z != INT64_MIN
+      || !ckd_sat_add(&y, cast(i64, -5), 3u) || y != 0)
+  {
+    report_sat_mismatch("ckd_sat", "i64", "u64", "i64", 0);
+    return true;
+  }
+  return false;
+}
+
+#ifdef __cplusplus
+
+#  define check_checked(T, U, V, W) \
+    do { \
+      long v = cast(long, cast(U, a)) * cast(V, b) + cast(W, c); \
+      long w = cast(long, cast(V, b)) - cast(U, a) * cast(long, cast(W, c)); \
+      ckd_checked<T> t = ckd_checked<U>(cast(U, a)) * cast(V, b) + cast(W, c); \
+      ckd_checked<T> u = cast(V, b) - ckd_checked<U>(cast(U, a)) * cast(W, c); \
+      if (t.failed != (v < cast(long, MIN_##T) || v > cast(long, MAX_##T)) \
+          || t.value != cast(T, cast(unsigned long, v)) \
+          || u.failed != (w < cast(long, MIN_##T) || w > cast(long, MAX_##T)) \
+          || (!u.failed && u.value != w)) \
+      { \
+        report_muladd_mismatch("ckd_checked<" #T ">", #U, #V, #W, v); \
+        return true; \
+      } \
+    } while (0)
+
+#  ifdef ckd_have_constant_evaluated
+// every backend falls back to the polyfill when evaluated at compile time
+template<typename T, typename U, typename V>
+constexpr T ckd_const_add(U a, V b)
+{
+  T z = 0;
+  return ckd_add(&z, a, b) ? 42 : z;
+}
+
+template<typename T, typename U, typename V>
+constexpr T ckd_const_sub(U a, V b)
+{
+  T z = 0;
+  return ckd_sub(&z, a, b) ? 42 : z;
+}
+
+template<typename T, typename U, typename V>
+constexpr T ckd_const_mul(U a, V b)
+{
+  T z = 0;
+  return ckd_mul(&z, a, b) ? 42 : z;
+}
+
+static_assert(ckd_const_add<i32>(INT32_MAX - 1, 1) == INT32_MAX, "");
+static_assert(ckd_const_add<i32>(INT32_MAX, 1) == 42, "");
+static_assert(ckd_const_add<u8>(-1, 256u) == 255, "");
+static_assert(ckd_const_sub<u64>(0, cast(i64, -1)) == 1, "");
+static_assert(ckd_const_sub<u32>(0u, 1) == 42, "");
+static_assert(ckd_const_mul<i64>(INT64_MIN, 1u) == INT64_MIN, "");
+static_assert(ckd_const_mul<i64>(INT64_MIN, -1) == 42, "");
+static_assert(ckd_const_mul<u16>(-256, -256) == 42, "");
+#  endif
+
+enum test_enum
+{
+  test_enum_max = INT32_MAX
+};
+
+// the builtins take char, bool and enum operands, so the templates that
+// wrap them can't stop taking them
+static bool test_loose_operands(void)
+{
+#  if !defined(__STRICT_ANSI__) && !defined(ckd_have_library)
+  int z = 0;
+  signed char c = 0;
+  if (ckd_add(&z, 'a', true) || z != 'b' || !ckd_mul(&z, test_enum_max, 2)
+      || ckd_sub(&c, 'a', false) || c != 'a')
+  {
+    report_muladd_mismatch("ckd_add", "int", "char", "bool", 0);
+    return true;
+  }
+#  endif
+  return false;
+}
+
+static bool test_checked(void)
+{
+  int a = 0;
+  int b = 0;
+  int c = 0;
+  ckd_checked<i32> x = INT32_MAX;
+  ckd_checked<i64> y = ckd_checked<i32>(INT32_MIN) * INT32_MIN - (1ll << 62);
+  ckd_checked<u32> z = ckd_checked<i64>(-5) * -3;
+  ckd_checked<u64> q = ckd_checked<u32>(~0u) * ~0u * 2;
+  ckd_checked<u64> d = ckd_checked<u32>(0u) - ~0u;
+  ckd_checked<u64> m = ckd_checked<i32>(INT32_MIN) * INT32_MIN
+                     + ckd_checked<i32>(INT32_MIN) * INT32_MIN;
+  ckd_checked<int> n = ckd_checked<int>(1) * cast(size_t, 3) + 4ull;
+  ckd_checked<int> w = ckd_checked<int>(1) * SIZE_MAX;
+  ckd_checked<int> v = ckd_checked<int>(1) + ULLONG_MAX;
+#  ifdef ckd_have_int128
+  ckd_checked<int> t = ckd_checked<int>(2) * cast(unsigned __int128, 3);
+  ckd_checked<int> h = ckd_checked<int>(1) * ~cast(unsigned __int128, 0);
+#  endif
+  for (a = 0; a != 256; ++a) {
+    for (b = 0; b != 256; ++b) {
+      c = a * 3 - b;
+      check_checked(i8, i8, i8, i8);
+      check_checked(u8, i8, u8, i16);
+      check_checked(i16, u8, i8, i8);
+      check_checked(u8, u8, u8, i16);
+    }
+  }
+  x += 1;
+  x *= 0;
+  if (!x.failed || y.failed || y.value || z.failed || z.value != 15
+      || !q.failed || !d.failed || n.failed || n.value != 7 || !w.failed
+      || !v.failed
+#  ifdef ckd_have_int128
+      || m.failed || m.value != 1ull << 63 || t.failed || t.value != 6
+      || !h.failed
+#  else
+      || !m.failed
+#  endif
+  )
+  {
+    report_muladd_mismatch("ckd_checked", "i64", "u32", "u64", 0);
+    return true;
+  }
+  return false;
+}
+
+static bool test_bounded(void)
+{
+  int a = 0;
+  int b = 0;
+  u8 p = 0;
+  u16 q = 0;
+  ckd_bounded<i8, -3, 9> r;
+  ckd_bounded<u32, 0, 1000> s =
+      ckd_constant<int, 999>() + ckd_constant<u8, 1>();
+  for (a = 1; a != 17; ++a) {
+    ckd_bounded<int, 1, 16> n;
+    if (ckd_set(&n, a)) {
+      report_muladd_mismatch("ckd_set", "int", "int", "int", a);
+      return true;
+    }
+    for (b = -128; b != 128; ++b) {
+      ckd_bounded<i8, -128, 127> k = cast(i8, b);
+      if (ckd_set(&p, n - 1) || p != a - 1
+          || ckd_set(&q, n * k + 2048) || q != a * b + 2048
+          || ckd_set(&r, k) != (b < -3 || b > 9)
+          || (b >= -3 && b <= 9 && r.value != b)
+          || ckd_set(&p, n + k) != (a + b < 0 || a + b > 255)
+          || ckd_set(&q, n - ckd_checked<int>(b) * b)
+                 != (a - b * b < 0))
+      {
+        report_muladd_mismatch("ckd_bounded", "int", "i8", "u16", a * b);
+        return true;
+      }
+    }
+  }
+  if (s.value != 1000 || !ckd_set(&s, s + 1) || s.value != 1000
+      || ckd_set(&s, s - 1000) || s.value)
+  {
+    report_muladd_mismatch("ckd_bounded", "u32", "u32", "u32", 1000);
+    return true;
+  }
+  return false;
+}
+
+#endif
+
+static void report_limbs_mismatch(char const* f, int k)
+{
+#define msg "Mismatch in %s, case %d\n"
+  assert(fprintf(stderr, msg, f, k) >= 0);
+#undef msg
+}
+
+#define check_limbs_n(f, zn, x, y, o, ...) \
+  do { \
+    u64 z[4] = {7, 7, 7, 7}; \
+    u64 const w[] = {__VA_ARGS__}; \
+    if (f(z, zn, x, sizeof(x) / 8, y, sizeof(y) / 8) != o \
+        || memcmp(z, w, sizeof(w)) || (zn < 4 && z[zn] != 7)) \
+    { \
+      report_limbs_mismatch(#f, __LINE__); \
+      return true; \
+    } \
+  } while (0)
+
+static bool test_bignum(void)
+{
+  u64 const ones[3] = {~0ull, ~0ull, ~0ull};
+  u64 const one[1] = {1};
+  u64 const two[2] = {2, 0};
+  u64 const big[3] = {0, 0, 1};
+  u64 const mid[2] = {0, 1};
+  u64 const sq[2] = {~0ull, ~0ull};
+  u64 const pad[3] = {5, 0, 0};
+  u32 const h[2] = {~0u, ~0u};
+  u32 q[4];
+  unsigned long long s = 0;
+  u64 r = 0;
+  size_t a = 0;
+  size_t b = 0;
+  if (!ckd_addc(&r, ~0ull, 0, true) || r != 0 || ckd_addc(&r, 1, 2, true)
+      || r != 4 || !ckd_subb(&r, 0, 0, true) || r != ~0ull
+      || ckd_subb(&r, 5, 2, true) || r != 2)
+  {
+    report_limbs_mismatch("ckd_addc", __LINE__);
+    return true;
+  }
+  check_limbs_n(ckd_add_limbs, 4, ones, one, false, 0, 0, 0, 1);
+  check_limbs_n(ckd_add_limbs, 3, one, ones, true, 0, 0, 0);
+  check_limbs_n(ckd_add_limbs, 1, pad, one, false, 6);
+  check_limbs_n(ckd_add_limbs, 1, big, one, true, 1);
+  check_limbs_n(ckd_sub_limbs, 3, big, one, false, ~0ull, ~0ull, 0);
+  check_limbs_n(ckd_sub_limbs, 2, big, one, false, ~0ull, ~0ull);
+  check_limbs_n(ckd_sub_limbs, 1, big, one, true, ~0ull);
+  check_limbs_n(ckd_sub_limbs, 3, one, two, true, ~0ull, ~0ull, ~0ull);
+  check_limbs_n(ckd_sub_limbs, 1, pad, one, false, 4);
+  check_limbs_n(ckd_mul_limbs, 4, sq, sq, false, 1, 0, ~0ull - 1, ~0ull);
+  check_limbs_n(ckd_mul_limbs, 3, sq, sq, true, 1, 0, ~0ull - 1);
+  check_limbs_n(ckd_mul_limbs, 3, big, mid, true, 0, 0, 0);
+  check_limbs_n(ckd_mul_limbs, 4, big, mid, false, 0, 0, 0, 1);
+  check_limbs_n(ckd_mul_limbs, 1, pad, two, false, 10);
+  check_limbs_n(ckd_mul_limbs, 2, one, pad, false, 5, 0);
+  if (ckd_mul_limbs(q, 4, h, 2, h, 2) || q[0] != 1 || q[1] != 0
+      || q[2] != ~1u || q[3] != ~0u || !ckd_add_limbs(q, 2, h, 2, q, 1)
+      || q[0] != 0 || q[1] != 0 || !ckd_subb(&s, 0ull, 1, false)
+      || s != ~0ull)
+  {
+    report_limbs_mismatch("ckd_mul_limbs", __LINE__);
+    return true;
+  }
+  for (a = 0; a != sizeof(ku64) / 8; ++a) {
+    for (b = 0; b != sizeof(ku64) / 8; ++b) {
+      u64 z[2] = {0, 0};
+      u64 t = 0;
+      ckd_u128 w;
+      if (ckd_add_limbs(z, 1, ku64 + a, 1, ku64 + b, 1)
+              != ckd_add(&t, ku64[a], ku64[b])
+          || z[0] != t
+          || ckd_sub_limbs(z, 1, ku64 + a, 1, ku64 + b, 1)
+              != ckd_sub(&t, ku64[a], ku64[b])
+          || z[0] != t || ckd_mul_limbs(z, 2, ku64 + a, 1, ku64 + b, 1)
+          || ckd_mul(&w, ku64[a], ku64[b]) || z[0] != ckd_u128_lo(w)
+          || z[1] != ckd_u128_hi(w)
+          || ckd_mul_limbs(z, 1, ku64 + a, 1, ku64 + b, 1)
+              != ckd_mul(&t, ku64[a], ku64[b])
+          || z[0] != t)
+      {
+        report_limbs_mismatch("ckd_mul_limbs", cast(int, a * 64 + b));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static void report_shape_mismatch(int line)
+{
+#define msg "Mismatch in ckd_shape, line %d\n"
+  assert(fprintf(stderr, msg, line) >= 0);
+#undef msg
+}
+
+static bool check_shape_walk(ckd_shape const* s, size_t n)
+{
+  ptrdiff_t ix[ckd_shape_max];
+  ptrdiff_t off = 0;
+  size_t m = 0;
+  if (ckd_shape_begin(s, ix, &off)) {
+    do {
+      if (off != ckd_shape_offset(s, ix)) {
+        return true;
+      }
+      ++m;
+    } while (ckd_shape_next(s, ix, &off));
+  }
+  return m != n || off != s->base;
+}
+
+static bool test_shape(void)
+{
+  size_t const dim[3] = {2, 3, 4};
+  size_t const huge[2] = {~cast(size_t, 0) / 2, 3};
+  size_t const empty[2] = {5, 0};
+  ptrdiff_t const flip[3] = {-12, 4, 1};
+  ptrdiff_t const bcast[3] = {0, 1, 0};
+  ptrdiff_t const big[3] = {PTRDIFF_MAX / 2, 1, 1};
+  ptrdiff_t const ix[3] = {1, 2, 3};
+  ckd_shape s;
+  if (ckd_shape_init(&s, 3, dim, nil, 0, 24) || s.stride[0] != 12
+      || s.stride[1] != 4 || s.stride[2] != 1
+      || ckd_shape_offset(&s, ix) != 23 || check_shape_walk(&s, 24))
+  {
+    report_shape_mismatch(__LINE__);
+    return true;
+  }
+  if (ckd_shape_init(&s, 3, dim, flip, 12, 24)
+      || ckd_shape_offset(&s, ix) != 11 || check_shape_walk(&s, 24)
+      || ckd_shape_init(&s, 3, dim, bcast, 7, 10)
+      || ckd_shape_offset(&s, ix) != 9 || check_shape_walk(&s, 24)
+      || ckd_shape_init(&s, 2, empty, nil, 0, 0) || check_shape_walk(&s, 0)
+      || ckd_shape_init(&s, 0, dim, nil, 3, 4) || check_shape_walk(&s, 1)
+      || ckd_shape_init(&s, 2, dim, big, 0, ~cast(size_t, 0)))
+  {
+    report_shape_mismatch(__LINE__);
+    return true;
+  }
+  if (!ckd_shape_init(&s, 3, dim, nil, 0, 23)
+      || !ckd_shape_init(&s, 3, dim, nil, 1, 24)
+      || !ckd_shape_init(&s, 3, dim, flip, 11, 24)
+      || !ckd_shape_init(&s, 2, huge, nil, 0, ~cast(size_t, 0))
+      || !ckd_shape_init(&s, 3, dim, big, PTRDIFF_MAX / 2, ~cast(size_t, 0))
+      || !ckd_shape_init(&s, ckd_shape_max + 1, dim, nil, 0, 24))
+  {
+    report_shape_mismatch(__LINE__);
+    return true;
+  }
+  return false;
+}
+
+bool other_affine(i8* res, int a, int b, size_t n);
+bool other_affine64(u64* res, u64 a, int b, size_t n);
+
+static bool test_affine(void)
+{
+  int a = 0;
+  int b = 0;
+  size_t k = 0;
+  size_t m = 0;
+  size_t const ns[] = {0, 1, 2, 3, 37, 300};
+  for (a = -300; a <= 300; a += 3) {
+    for (b = -260; b <= 260; b += 7) {
+      for (k = 0; k < sizeof(ns) / sizeof(ns[0]); ++k) {
+        i8 x = 5;
+        i8 v = 5;
+        u8 y = 5;
+        int z = 0;
+        bool ox = false;
+        bool oy = false;
+        for (m = 0; m < ns[k]; ++m) {
+          if (ckd_muladd(&z, cast(int, m), b, a)) {
+            ox = oy = true;
+          }
+          ox |= ckd_add(&x, z, 0);
+          oy |= ckd_add(&y, z, 0);
+        }
+        if (ckd_affine(&x, a, b, ns[k]) != ox
+            || ckd_affine(&y, cast(i16, a), cast(i16, b), ns[k]) != oy
+            || other_affine(&v, a, b, ns[k]) != ox || v != x
+            || (!ox && ns[k] && x != a + cast(int, ns[k] - 1) * b)
+            || (!ns[k] && (x != 5 || y != 5)))
+        {
+          report_muladd_mismatch("ckd_affine", "int", "int", "size_t", a);
+          return true;
+        }
+      }
+    }
+  }
+  {
+    u64 u = 0;
+    i64 s = 0;
+    size_t w = 0;
+    if (ckd_affine(&u, UINT64_MAX, -1, SIZE_MAX)
+        || u != UINT64_MAX - SIZE_MAX + 1 || ckd_affine(&w, 1, 1, SIZE_MAX)
+        || w != SIZE_MAX || !ckd_affine(&w, 2, 1, SIZE_MAX)
+        || ckd_affine(&s, INT64_MIN, UINT64_MAX / 2, 3) || s != INT64_MAX - 1
+        || !ckd_affine(&s, INT64_MIN, UINT64_MAX / 2 + 1, 3)
+        || ckd_affine(&s, INT64_MAX, 0u, 2) || s != INT64_MAX
+        || other_affine64(&u, UINT64_MAX, -1, SIZE_MAX)
+        || u != UINT64_MAX - SIZE_MAX + 1
+        || !other_affine64(&u, 1, -1, 3))
+    {
+      report_muladd_mismatch("ckd_affine", "i64", "u64", "size_t", 0);
+      return true;
+    }
+  }
+  return false;
+}
+
+// The reference is mapped into memory when possible, and otherwise read
+// with a single call, so records can then be read in place.
+static bool load_reference(char const* path)
+{
+#ifdef HAVE_POSIX
+  struct stat st;
+  void* map = nil;
+  int fd = open(path, O_RDONLY);
+  if (fd == -1 || fstat(fd, &st) || !st.st_size) {
+    perror(path);
+    return true;
+  }
+  reference_size = cast(size_t, st.st_size);
+  map = mmap(nil, reference_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror(path);
+    return true;
+  }
+  reference = cast(unsigned char*, map);
+#else
+  long n = 0;
+  FILE* f = fopen(path, "rb");
+  if (!f || fseek(f, 0, SEEK_END) || (n = ftell(f)) <= 0
+      || fseek(f, 0, SEEK_SET))
+  {
+    perror(path);
+    return true;
+  }
+  reference_size = cast(size_t, n);
+  if (!(reference = cast(unsigned char*, malloc(reference_size)))
+      || fread(reference, 1, reference_size, f) != reference_size)
+  {
+    perror(path);
+    return true;
+  }
+  assert(fclose(f) == 0);
+#endif
+  return false;
+}
+
+static void unload_reference(void)
+{
+#ifdef HAVE_POSIX
+  assert(munmap(reference, reference_size) == 0);
+#else
+  free(reference);
+#endif
+}
+
+// Every section of the reference is independent, so they're verified
+// concurrently, with one thread per result type and pass.
+static bool (*const kJobs[])(void) = {
+#define X(S, N) test_##S##N,
+    FOR_TYPES(X)
+#undef X
+#ifdef ckd_have_limbs
+#  define X(T) test_limbs_##T,
+        FOR_LIMB_TYPES(X)
+#  undef X
+#endif
+};
+
+#define JOBS (sizeof(kJobs) / sizeof(kJobs[0]))
+
+static struct job
+{
+  bool (*fn)(void);
+  bool failed;
+#ifdef HAVE_POSIX
+  pthread_t th;
+#endif
+} jobs[JOBS];
+
+static void* run_job(void* arg)
+{
+  struct job* job = cast(struct job*, arg);
+  job->failed = job->fn();
+  return nil;
+}
+
+static bool check_reference(void)
+{
+  size_t k;
+  bool o = false;
+  for (k = 0; k < JOBS; ++k) {
+    jobs[k].fn = kJobs[k];
+  }
+#ifdef HAVE_POSIX
+  for (k = 0; k < JOBS; ++k) {
+    if (pthread_create(&jobs[k].th, nil, run_job, &jobs[k])) {
+      run_job(&jobs[k]);
+      jobs[k].th = pthread_self();
+    }
+  }
+  for (k = 0; k < JOBS; ++k) {
+    if (!pthread_equal(jobs[k].th, pthread_self())) {
+      assert(pthread_join(jobs[k].th, nil) == 0);
+    }
+    o |= jobs[k].failed;
+  }
+#else
+  for (k = 0; k < JOBS; ++k) {
+    run_job(&jobs[k]);
+    o |= jobs[k].failed;
+  }
+#endif
+  return o;
+}
+
+// A random corpus written by `./corpus SEED SIZE` may be verified with
+// `./test random.bin` which reads one chunk at a time, and generates the
+// same operands, so it can be larger than memory. See corpus.c for the
+// format. The generator below must stay the same as the one in there.
+
+#define STREAM_HEADER 20
+#define STREAM_CASES (3 * 8 * 8 * 8)
+
+static int const kStreamBits[8] = {8, 16, 32, 64, 8, 16, 32, 64};
+static bool const kStreamSigned[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+static char const* const kStreamTypes[8] = {
+    "u8_t", "u16_t", "u32_t", "u64_t", "i8_t", "i16_t", "i32_t", "i64_t"};
+static char const* const kStreamOps[3] = {"ckd_add", "ckd_sub", "ckd_mul"};
+
+static u64 stream_next(u64* s)
+{
+  u64 z = (*s += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static u64 stream_max(int t)
+{
+  return ~0ull >> (64 - kStreamBits[t] + kStreamSigned[t]);
+}
+
+static u64 stream_min(int t)
+{
+  return kStreamSigned[t] ? ~stream_max(t) : 0;
+}
+
+static u64 stream_pick(u64* s, int t)
+{
+  u64 x;
+  u64 r = stream_next(s);
+  int bits = kStreamBits[t];
+  switch (r & 7) {
+    case 0:
+      x = 0;
+      break;
+    case 1:
+      x = stream_max(t);
+      break;
+    case 2:
+      x = 1ull << (r >> 8) % cast(unsigned, bits);
+      break;
+    case 3:
+      x = 1ull << bits / 2;
+      break;
+    default:
+      x = stream_next(s) >> (r >> 8) % 64;
+      break;
+  }
+  x += (r >> 16) % 5 - 2;
+  if (r >> 24 & 1) {
+    x = 0 - x;
+  }
+  if (bits < 64) {
+    x &= ~(~0ull << bits);
+    if (kStreamSigned[t] && (x >> (bits - 1) & 1)) {
+      x |= ~0ull << bits;
+    }
+  }
+  return x;
+}
+
+/* clang-format off */
+#define SR(F, op, T, U, V) F(op, T, U, V)
+#define SRM(F, op, T, U) \
+  SR(F, op, T, U, u8) SR(F, op, T, U, u16) \
+  SR(F, op, T, U, u32) SR(F, op, T, U, u64) \
+  SR(F, op, T, U, i8) SR(F, op, T, U, i16) \
+  SR(F, op, T, U, i32) SR(F, op, T, U, i64)
+#define SRMM(F, op, T) \
+  SRM(F, op, T, u8) SRM(F, op, T, u16) \
+  SRM(F, op, T, u32) SRM(F, op, T, u64) \
+  SRM(F, op, T, i8) SRM(F, op, T, i16) \
+  SRM(F, op, T, i32) SRM(F, op, T, i64)
+#define SRMMM(F, op) \
+  SRMM(F, op, u8) SRMM(F, op, u16) \
+  SRMM(F, op, u32) SRMM(F, op, u64) \
+  SRMM(F, op, i8) SRMM(F, op, i16) \
+  SRMM(F, op, i32) SRMM(F, op, i64)
+#define FOR_STREAM_CASES(F) SRMMM(F, add) SRMMM(F, sub) SRMMM(F, mul)
+/* clang-format on */
+
+#define F(op, T, U, V) \
+  static bool stream_##op##_##T##_##U##_##V(u64 a, u64 b, u64* z) \
+  { \
+    T r = 0; \
+    bool o = ckd_##op(&r, cast(U, a), cast(V, b)); \
+    *z = cast(u64, r); \
+    return o; \
+  }
+FOR_STREAM_CASES(F)
+#undef F
+
+static bool (*const kStreamCases[STREAM_CASES])(u64, u64, u64*) = {
+#define F(op, T, U, V) stream_##op##_##T##_##U##_##V,
+    FOR_STREAM_CASES(F)
+#undef F
+};
+
+// Returns the end of the record at p, or nil if it's malformed.
+static unsigned char const* stream_decode(unsigned char const* p,
+                                          unsigned char const* e,
+                                          u64* z,
+                                          bool* o,
+                                          int t)
+{
+  int shift = 4;
+  unsigned char b = *p++;
+  int anchor = b >> 1 & 3;
+  u64 d = cast(u64, b >> 3 & 15);
+  *o = (b & 1) != 0;
+  while (b & 0x80) {
+    if (p == e || shift > 63) {
+      return nil;
+    }
+    b = *p++;
+    d |= cast(u64, b & 127) << shift;
+    shift += 7;
+  }
+  switch (anchor) {
+    case 0:
+      *z = d >> 1 ^ (0 - (d & 1));
+      return p;
+    case 1:
+      *z = stream_min(t) + d;
+      return p;
+    case 2:
+      *z = stream_max(t) - d;
+      return p;
+    default:
+      return nil;
+  }
+}
+
+static bool stream_read(FILE* f, unsigned char* p, size_t n, char const* path)
+{
+  if (fread(p, 1, n, f) != n) {
+#define msg "%s: truncated\n"
+    assert(fprintf(stderr, msg, path) >= 0);
+#undef msg
+    return false;
+  }
+  return true;
+}
+
+static bool check_stream(char const* path)
+{
+  u64 k, seed;
+  u64 chunks = 0;
+  u64 total = 0;
+  size_t cap = 0;
+  unsigned char head[STREAM_HEADER];
+  unsigned char* data = nil;
+  bool o = true;
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return true;
+  }
+  if (!stream_read(f, head, sizeof(head), path)
+      || memcmp(head, "JTCKDRND", 8) || read_be(head + 8, 4) != 1)
+  {
+    assert(fprintf(stderr, "%s is not a random corpus\n", path) >= 0);
+    assert(fclose(f) == 0);
+    return true;
+  }
+  seed = read_be(head + 12, 8);
+  for (;;) {
+    u64 s = seed ^ chunks * 0xd1342543de82ef95ull;
+    size_t bytes;
+    u64 records;
+    unsigned char const* p;
+    unsigned char const* e;
+    if (!stream_read(f, head, 8, path)) {
+      break;
+    }
+    bytes = cast(size_t, read_be(head, 4));
+    records = read_be(head + 4, 4);
+    if (!records) {
+      o = bytes != 0 || fgetc(f) != EOF;
+      if (o) {
+        assert(fprintf(stderr, "%s: junk after the last chunk\n", path) >= 0);
+      }
+      break;
+    }
+    if (bytes > cap) {
+      unsigned char* q = cast(unsigned char*, realloc(data, bytes));
+      if (!q) {
+        perror(path);
+        break;
+      }
+      data = q;
+      cap = bytes;
+    }
+    if (!stream_read(f, data, bytes, path)) {
+      break;
+    }
+    s = stream_next(&s);
+    p = data;
+    e = data + bytes;
+    for (k = 0; k < records; ++k) {
+      u64 z1, z2;
+      bool o1, o2 = false;
+      u32 n = cast(u32, stream_next(&s) % STREAM_CASES);
+      int t = cast(int, n / 64 % 8);
+      int u = cast(int, n / 8 % 8);
+      int v = cast(int, n % 8);
+      u64 a = stream_pick(&s, u);
+      u64 b = stream_pick(&s, v);
+      o1 = kStreamCases[n](a, b, &z1);
+      if (p == e || !(p = stream_decode(p, e, &z2, &o2, t))) {
+#define msg "%s: chunk %lu is corrupt\n"
+        assert(fprintf(stderr, msg, path, cast(unsigned long, chunks)) >= 0);
+#undef msg
+        goto done;
+      }
+      if (o1 != o2 || z1 != z2) {
+#define msg \
+  "Mismatch in %s chunk %lu record %lu\n  Actual:   (%c) 0x%llX\n" \
+  "  Expected: (%c) 0x%llX\n  Operation: %s(%s, %s 0x%llX, %s 0x%llX)\n"
+        assert(fprintf(stderr,
+                       msg,
+                       path,
+                       cast(unsigned long, chunks),
+                       cast(unsigned long, k),
+                       '0' + o1,
+                       cast(unsigned long long, z1),
+                       '0' + o2,
+                       cast(unsigned long long, z2),
+                       kStreamOps[n / 512],
+                       kStreamTypes[t],
+                       kStreamTypes[u],
+                       cast(unsigned long long, a),
+                       kStreamTypes[v],
+                       cast(unsigned long long, b))
+               >= 0);
+#undef msg
+        goto done;
+      }
+    }
+    if (p != e) {
+#define msg "%s: chunk %lu has junk after its records\n"
+      assert(fprintf(stderr, msg, path, cast(unsigned long, chunks)) >= 0);
+#undef msg
+      break;
+    }
+    total += records;
+    ++chunks;
+  }
+  if (!o) {
+#define msg "+ [%s] %llu random operations\n"
+    assert(printf(msg, path, cast(unsigned long long, total)) >= 0);
+#undef msg
+  }
+done:
+  free(data);
+  assert(fclose(f) == 0);
+  return o;
+}
+
 bool test_odr(int a, int b);
 
 static char const* get_platform(int x)
@@ -340,10 +1683,88 @@ static char const* get_platform(int x)
   return "unknown";
 }
 
-int main(int argc, char* argv[])
+#ifdef ckd_have_stats
+// counts the calls and overflows reported for a line of this file
+static void stats_find(char const* path,
+                       int line,
+                       unsigned long long* calls,
+                       unsigned long long* fails)
+{
+  char buf[512], want[64];
+  FILE* f = fopen(path, "r");
+  sprintf(want, ",%d,", line);
+  *calls = *fails = 0;
+  if (!f) {
+    return;
+  }
+  while (fgets(buf, sizeof(buf), f)) {
+    char* p = strstr(buf, want);
+    if (p && (size_t)(p - buf) == strlen(__FILE__)
+        && !strncmp(buf, __FILE__, strlen(__FILE__)))
+    {
+      p = strrchr(buf, ',');
+      *fails = strtoull(p + 1, nil, 10);
+      *p = 0;
+      *calls = strtoull(strrchr(buf, ',') + 1, nil, 10);
+    }
+  }
+  fclose(f);
+}
+
+#  ifdef __cplusplus
+// an operand whose template arguments have a comma
+template<typename T, typename U>
+static T pick(T x, U)
+{
+  return x;
+}
+#  endif
+
+static bool test_stats(void)
 {
-  (void)argv;
+  i8 x = 0;
+  u64 y = 0;
+  int i, add_line, mul_line, ctx_line, trap_line;
+  unsigned long long calls, fails;
+  bool bad = false;
+  ckd_ctx c;
+  ckd_ctx_init(&c);
+  for (i = 0; i < 300; ++i) {
+#  ifdef __cplusplus
+    add_line = __LINE__ + 1;
+    ckd_add(&x, pick<int, long>(i, 0), -100);
+#  else
+    add_line = __LINE__ + 1;
+    ckd_add(&x, i, -100);
+#  endif
+    mul_line = __LINE__ + 1;
+    ckd_mul(&y, i + 1, cast(i64, -1));
+    ctx_line = __LINE__ + 1;
+    ckd_ctx_add(&c, &x, i, 100);
+    trap_line = __LINE__ + 1;
+    ckd_sub_or_trap(&y, i + 1, 1);
+  }
+  bad |= ckd_stats_dump("stats.csv") != 0;
+  stats_find("stats.csv", add_line, &calls, &fails);
+  bad |= calls != 300 || fails != 72;
+  stats_find("stats.csv", mul_line, &calls, &fails);
+  bad |= calls != 300 || fails != 300;
+  stats_find("stats.csv", ctx_line, &calls, &fails);
+  bad |= calls != 300 || fails != 272 || !ckd_ctx_failed(&c);
+  stats_find("stats.csv", trap_line, &calls, &fails);
+  bad |= calls != 300 || fails != 0;
+  remove("stats.csv");
+  if (bad) {
+#  define msg "Mismatch in ckd_stats\n"
+    assert(fprintf(stderr, msg) >= 0);
+#  undef msg
+  }
+  return bad;
+}
+#endif
 
+int main(int argc, char* argv[])
+{
 #ifdef ckd_have_int128
 #  define msg "+ [%s] intmax: 128\n"
 #else
@@ -352,40 +1773,33 @@ int main(int argc, char* argv[])
   assert(printf(msg, get_platform(argc < 0)) >= 0);
 #undef msg
 
-  if (!test_odr(1, -1)) {
+  if (!test_odr(1, -1) || test_span() || test_reduce() || test_muladd()
+      || test_ctx() || test_or() || test_sat() || test_bignum() || test_shape()
+      || test_affine())
+  {
     return 1;
   }
 
-  assert(reference = fopen("test.bin", "rb"));
-
-#define X(S, N) \
-  if (test_##S##N()) { \
-    return 1; \
+#ifdef __cplusplus
+  if (test_checked() || test_bounded() || test_loose_operands()) {
+    return 1;
   }
-  FOR_TYPES(X)
-#undef X
+#endif
 
-#ifndef ckd_have_int128
-  for (;;) {
-    if (fread(&ref, 1, 1, reference) != 1) {
-      break;
-    }
-    assert((ref & 0x80) != 0);
-    assert(fseek(reference, ref & 0x3F, SEEK_CUR) == 0);
+#ifdef ckd_have_stats
+  if (test_stats()) {
+    return 1;
   }
 #endif
 
-  if (fgetc(reference) != EOF || !feof(reference)) {
-    long current = ftell(reference);
-    long end = 0;
-    assert(fseek(reference, 0, SEEK_END) == 0);
-    end = ftell(reference);
-#define msg "Reference was not read to completion. %ld bytes left.\n"
-    assert(fprintf(stderr, msg, end - current) >= 0);
-#undef msg
+  if (load_reference("test.bin") || check_reference()) {
+    return 1;
+  }
+
+  if (argc > 1 && check_stream(argv[1])) {
     return 1;
   }
 
-  assert(fclose(reference) == 0);
+  unload_reference();
   return 0;
 }
@@ -1,12 +1,31 @@
 #!/bin/sh
 set -ex
 
+# the usdt probes need systemtap's header
+if echo '#include <sys/sdt.h>' | cc -E -xc - >/dev/null 2>&1; then
+  usdt=1
+else
+  usdt=
+fi
+
 for cc in clang cc; do
   for opt in -O0 -O3 -fsanitize=undefined; do
     make clean
     make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt"
     make clean
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -U__SIZEOF_INT128__"
+    make clean
     make CC="$cc -Wall -Wextra -Wno-parentheses -Werror -pedantic-errors $opt -std=c11"
+    make clean
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror -pedantic-errors $opt -std=c11 -DJTCKDINT_OPTION_FLAGS=1"
+    make clean
+    make lib check CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_LIBRARY=1" LDLIBS="-pthread libjtckdint.a"
+    make clean
+    make lib check CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_STATS=1" LDLIBS="-pthread libjtckdint.a"
+    if [ $usdt ]; then
+      make clean
+      make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_USDT=1"
+    fi
   done
 done
 
@@ -15,7 +34,21 @@ for cc in c++ clang++; do
     make clean
     make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt" CFLAGS="-xc++"
     make clean
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -U__SIZEOF_INT128__" CFLAGS="-xc++"
+    make clean
     make CC="$cc -Wall -Wextra -Wno-parentheses -Werror -pedantic-errors $opt -std=c++11" CFLAGS="-xc++"
+    make clean
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror -pedantic-errors $opt -std=c++11 -DJTCKDINT_OPTION_FLAGS=1" CFLAGS="-xc++"
+    make clean
+    make lib
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_LIBRARY=1" CFLAGS="-xc++" LDLIBS="-pthread libjtckdint.a"
+    make clean
+    make lib
+    make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_STATS=1" CFLAGS="-xc++" LDLIBS="-pthread libjtckdint.a"
+    if [ $usdt ]; then
+      make clean
+      make CC="$cc -Wall -Wextra -Wno-parentheses -Werror $opt -DJTCKDINT_OPTION_USDT=1" CFLAGS="-xc++"
+    fi
   done
 done
 
@@ -0,0 +1,49 @@
+// run ./usdt.sh
+
+#include "jtckdint.h"
+
+#include <limits.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+#  define cast(T, x) (static_cast<T>(x))
+#else
+#  define cast(T, x) ((T)(x))
+#endif
+
+// Each case fails once, and writes the arguments its probe should have,
+// in the same format as the bpftrace program in usdt.sh, to argv[1].
+// Operands are volatile, so nothing gets constant folded.
+
+static volatile int int_max = INT_MAX;
+static volatile long long llong_min = LLONG_MIN;
+static volatile int zero = 0;
+
+int main(int argc, char* argv[])
+{
+  int i;
+  unsigned u;
+  unsigned char c;
+  long long ll;
+  unsigned long ul;
+  FILE* f;
+  if (argc < 2 || !(f = fopen(argv[1], "w"))) {
+    return 1;
+  }
+  if (ckd_add(&i, int_max, 1)) {
+    fprintf(f, "0 %d 1 9 9 9\n", INT_MAX);
+  }
+  if (ckd_sub(&u, cast(unsigned, zero), 1)) {
+    fprintf(f, "1 0 1 8 8 9\n");
+  }
+  if (ckd_mul(&c, zero + 16, 16)) {
+    fprintf(f, "2 16 16 2 9 9\n");
+  }
+  if (ckd_mul(&ll, llong_min, -1)) {
+    fprintf(f, "2 %lld -1 17 17 9\n", LLONG_MIN);
+  }
+  if (ckd_add(&ul, zero - 5, 2)) {
+    fprintf(f, "0 -5 2 16 9 9\n");
+  }
+  return fclose(f) != 0;
+}
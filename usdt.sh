@@ -0,0 +1,32 @@
+#!/bin/sh
+# checks that failing operations fire the jtckdint:overflow usdt probe
+# needs <sys/sdt.h>, and bpftrace run as root to see the probes fire
+
+set -e
+
+if ! echo '#include <sys/sdt.h>' | cc -E -xc - >/dev/null 2>&1; then
+  echo "usdt.sh: <sys/sdt.h> not found, e.g. install systemtap-sdt-dev" >&2
+  exit 1
+fi
+
+prog='usdt:./usdt:jtckdint:overflow {
+  printf("%d %d %d %d %d %d\n",
+         arg0, (int64)arg1, (int64)arg2, arg3, arg4, arg5);
+}'
+
+run() {
+  label=$1
+  shift
+  "$@" -O2 -DJTCKDINT_OPTION_USDT=1 -o usdt usdt.c
+  echo "$label: $(readelf -n usdt | grep -c 'Name: overflow') probe sites"
+  if command -v bpftrace >/dev/null && [ "$(id -u)" = 0 ]; then
+    bpftrace -q -e "$prog" -c './usdt usdt.want' | sort >usdt.got
+    sort usdt.want | diff - usdt.got
+    echo "$label: every probe fired with the right arguments"
+  fi
+}
+
+run builtins cc
+run c11 cc -std=c11
+run c++11 c++ -std=c++11 -xc++
+rm -f usdt usdt.want usdt.got